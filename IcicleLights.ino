@@ -28,7 +28,7 @@
 #include <OctoWS2811.h>
 #include <Wire.h>
 #include <SPI.h>
-#include <FlexCAN.h>
+#include <SD.h>
 #include <XPT2046_Touchscreen.h>
 #include <RamMonitor.h>
 
@@ -50,6 +50,13 @@ void
 SetupIcicleModule(
 	void);
 
+// Call from loop() with each Art-Net payload a transport receives, the module shows the frames from its own update.
+//	The ESP8266 module doesn't hand over UDP yet so host/icicle_host stream_listen is the only receiver so far
+void
+IcicleStream_Receive(
+	uint8_t const*	inPacket,
+	uint32_t		inBytes);
+
 void 
 setup(
 	void)
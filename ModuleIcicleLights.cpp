@@ -29,8 +29,19 @@
 
 */
 
+// Set to 0 to step the icicles with the plain C++ loop even where SSE2 or the Cortex-M4 DSP instructions are available,
+//	the host tests check that both give the same frames
+#if !defined(ICICLE_SIMD)
+	#define ICICLE_SIMD 1
+#endif
+
 #if !defined(WIN32)
 	#include <OctoWS2811.h>
+	#include <RamMonitor.h>
+#endif
+
+#if ICICLE_SIMD && defined(__SSE2__)
+	#include <emmintrin.h>
 #endif
 
 #include <EL.h>
@@ -49,20 +60,180 @@
 #include <ELOutdoorLightingControl.h>
 #include <ELRemoteLogging.h>
 
+// Set to 1 to keep the settings in a simulated EEPROM in RAM when running the module off the device
+#if !defined(ICICLE_SIMULATED_EEPROM)
+	#if defined(WIN32)
+		#define ICICLE_SIMULATED_EEPROM 1
+	#else
+		#define ICICLE_SIMULATED_EEPROM 0
+	#endif
+#endif
+
+#if !ICICLE_SIMULATED_EEPROM
+	#include <EEPROM.h>
+#endif
+
+// Shows are recorded on the card slot of a Teensy 3.5 or 3.6, the sketch must also include SD.h. A card on SPI needs
+//	ICICLE_SHOW_SD set to 1 and ICICLE_SHOW_SD_CS set to a free pin. Without a card the shows go in a buffer of
+//	ICICLE_SHOW_RAM_BYTES, off the device that holds a fraction of a second of dynamic ice for the benches and on the
+//	device it is 0 so there is nothing to record to
+#if !defined(ICICLE_SHOW_SD)
+	#if !defined(WIN32) && (defined(__MK64FX512__) || defined(__MK66FX1M0__))
+		#define ICICLE_SHOW_SD 1
+	#else
+		#define ICICLE_SHOW_SD 0
+	#endif
+#endif
+
+#if ICICLE_SHOW_SD
+	#include <SD.h>
+
+	#if !defined(ICICLE_SHOW_SD_CS)
+		#if defined(BUILTIN_SDCARD)
+			#define ICICLE_SHOW_SD_CS BUILTIN_SDCARD
+		#else
+			// Pin 10 would be the usual choice but it is the chip select of the DS3234 clock
+			#error "Set ICICLE_SHOW_SD_CS to the chip select pin of the SD card"
+		#endif
+	#endif
+#elif !defined(ICICLE_SHOW_RAM_BYTES)
+	#if defined(WIN32)
+		#define ICICLE_SHOW_RAM_BYTES 32768
+	#else
+		#define ICICLE_SHOW_RAM_BYTES 0
+	#endif
+#endif
+
+// Set to 1 for a roofline of controllers that share frame syncs and settings over CAN, the sketch must also include
+//	FlexCAN.h. Without it each controller paces itself, a shard still streams its own universes
+#if !defined(ICICLE_CAN)
+	#define ICICLE_CAN 0
+#endif
+
+// Set to 1 to put the controllers on a simulated CAN bus in RAM when running the module off the device
+#if !defined(ICICLE_SIMULATED_CAN)
+	#if defined(WIN32)
+		#define ICICLE_SIMULATED_CAN 1
+	#else
+		#define ICICLE_SIMULATED_CAN 0
+	#endif
+#endif
+
+#if ICICLE_CAN && !ICICLE_SIMULATED_CAN
+	#include <FlexCAN.h>
+#endif
+
+// Set to 0 to compile the perf_stats timing out of the frame pipeline
+#if !defined(ICICLE_PERF_STATS)
+	#define ICICLE_PERF_STATS 1
+#endif
+
+// Set to 0 to keep the hold and drip times of the icicles at full width instead of packed, the host tests run both
+//	models tick for tick and compare them
+#if !defined(ICICLE_PACKED_ICICLES)
+	#define ICICLE_PACKED_ICICLES 1
+#endif
+
+// The RAM of the board, the memory report on the home page measures the static buffers against it
+#if !defined(ICICLE_BOARD_RAM_BYTES)
+	#if defined(__MK20DX256__)
+		#define ICICLE_BOARD_RAM_BYTES 65536
+	#elif defined(__MK64FX512__)
+		#define ICICLE_BOARD_RAM_BYTES 196608
+	#elif defined(__MK66FX1M0__)
+		#define ICICLE_BOARD_RAM_BYTES 262144
+	#else
+		#define ICICLE_BOARD_RAM_BYTES 0
+	#endif
+#endif
+
+// Set to 0 to draw each frame straight into the DMA memory once the frame before it is out, instead of into a second
+//	buffer that leds.show() copies over. It saves a frame of DMA memory on a board that can't spare it
+#if !defined(ICICLE_DRAW_BUFFER)
+	#if ICICLE_BOARD_RAM_BYTES > 0 && ICICLE_BOARD_RAM_BYTES <= 65536
+		#define ICICLE_DRAW_BUFFER 0
+	#else
+		#define ICICLE_DRAW_BUFFER 1
+	#endif
+#endif
+
+// The shape of an installation, strips of icicles that all have the same number of LEDs with eSkippedLEDsPerStrip dark
+//	LEDs on each strip. The module is built for ICICLE_GEOMETRY, geometry_bench also builds the render kernels for a few
+//	other shapes
+template<int tStripCount, int tIciclesPerStrip, int tLEDsPerIcicle, int tSkippedLEDsPerStrip = 0>
+struct SIcicleGeometry
+{
+	enum
+	{
+		eStripCount = tStripCount,
+		eIciclesPerStrip = tIciclesPerStrip,
+		eLEDsPerIcicle = tLEDsPerIcicle,
+		eSkippedLEDsPerStrip = tSkippedLEDsPerStrip,
+		eLEDsPerStrip = tIciclesPerStrip * tLEDsPerIcicle + tSkippedLEDsPerStrip,
+		eIcicleTotal = tIciclesPerStrip * tStripCount,
+
+		// OctoWS2811 clocks all 8 of its outputs out of one buffer, a byte per color bit of each LED
+		eDMABytes = eLEDsPerStrip * 24,
+	};
+
+	static_assert(tStripCount >= 1 && tStripCount <= 8, "OctoWS2811 has 8 outputs");
+	static_assert(tIciclesPerStrip >= 1 && tLEDsPerIcicle >= 1 && tSkippedLEDsPerStrip >= 0, "a strip needs icicles");
+	static_assert(eLEDsPerStrip * tStripCount <= 0x8000, "gIcicleLEDMap holds 15 bit LED indexes");
+};
+
+#if !defined(ICICLE_GEOMETRY)
+	#define ICICLE_GEOMETRY SIcicleGeometry<8, 108, 5, 0>
+#endif
+
+typedef ICICLE_GEOMETRY	SInstallGeometry;
+
 enum
 {
-	eIciclesPerStrip = 108,
-	eLEDsPerIcicle = 5,
-	eLEDsPerStrip = eIciclesPerStrip * eLEDsPerIcicle,
-	eStripCount = 8,
-	eIcicleTotal = eIciclesPerStrip * eStripCount,
+	eIciclesPerStrip = SInstallGeometry::eIciclesPerStrip,
+	eLEDsPerIcicle = SInstallGeometry::eLEDsPerIcicle,
+	eSkippedLEDsPerStrip = SInstallGeometry::eSkippedLEDsPerStrip,
+	eLEDsPerStrip = SInstallGeometry::eLEDsPerStrip,
+	eStripCount = SInstallGeometry::eStripCount,
+	eIcicleTotal = SInstallGeometry::eIcicleTotal,
 
 	eToggleButtonPin = 9,
 	eTransformerRelayPin = 17,
 	eMotionSensorPin = 22,
 	eESP8266ResetPint = 23,
 
-	eUpdateTimeUS = 30000,
+	// The module ticks much faster than the frame rate so each frame can be started on its own schedule
+	eUpdateTimeUS = 1000,
+	eFrameIntervalDefaultUS = 30000,
+
+	// A page starts out in slices this small until the time the client takes to take one is known
+	eWebSliceStartBytes = 32,
+
+	// A frame can't go out faster than the DMA clocks a strip out, 30us per LED plus the 300us latch
+	eFrameIntervalMinUS = eLEDsPerStrip * 30 + 300,
+	eFrameIntervalMaxUS = 1000000,
+
+	// The settings are saved this long after the last change so a burst of set commands is one write, the writes are
+	//	spread over the updates
+	eSettingsVersion = 9,
+	eSettingsSlotCount = 4,
+	eSettingsQuietUS = 5000000,
+	eSettingsFlushBytesPerUpdate = 8,
+
+	// The settings slots sit at the end of the EEPROM, clear of the modules that save through CModule. E2END comes from
+	//	the Teensy core so this follows the board, the simulated EEPROM is the 2KB of a Teensy 3.1/3.2
+#if ICICLE_SIMULATED_EEPROM
+	eEEPROMSize = 2048,
+#else
+	eEEPROMSize = E2END + 1,
+#endif
+
+	eParamApply_Reset = 0,
+	eParamApply_Lazy = 1,
+	eParamApply_Count = 2,
+
+	eFramePacing_Fixed = 0,
+	eFramePacing_Adaptive = 1,
+	eFramePacing_Count = 2,
 
 	eRenderMode_StaticIce = 0,
 	eRenderMode_DynamicIce = 1,
@@ -70,10 +241,109 @@ enum
 	eRenderMode_AllOff = 3,
 	eRenderMode_Festive = 4,
 	eRenderMode_Strand = 5,
-	eRenderMode_Count = 6,
+	eRenderMode_Playback = 6,
+	eRenderMode_Count = 7,
+
+	// Not a setting, the stream takes over from the set mode while Art-Net frames are arriving
+	eRenderMode_Stream = eRenderMode_Count,
+
+	// Art-Net ArtDmx packets carry 170 RGB LEDs each, every strip starts on its own universe
+	eStreamLEDsPerUniverse = 170,
+	eStreamUniversesPerStrip = (eLEDsPerStrip + eStreamLEDsPerUniverse - 1) / eStreamLEDsPerUniverse,
+	eStreamUniverseCount = eStreamUniversesPerStrip * eStripCount,
+	eStreamHeaderSize = 18,
+	eStreamOpCode_Dmx = 0x5000,
+	eStreamOpCode_Sync = 0x5200,
+
+	// A recorded show is a header and then one record per frame of the DMA buffer, see CModule_Icicle::ShowRecord_Frame()
+	eShowVersion = 1,
+	eShowHeaderSize = 8,
+	eShowFrameBytes = eLEDsPerStrip * 24,
+	eShowChunkSize = 256,
+	eShowKeyframeIntervalDefault = 64,
+	eShowKeyframeIndexMax = 128,
+	eShowScanRecordsPerUpdate = 16,
+	eShowIndexFooterSize = 8,
+	eShowTag_Keyframe = 'K',
+	eShowTag_Delta = 'D',
+	eShowTag_Index = 'I',
+
+	// Several controllers can each drive a shard of a longer roofline, node 0 paces the frames for all of them. A sync
+	//	message tells the others when to present the next frame, eCANSyncLeadUS ahead so it arrives in time
+	eCANBitRate = 1000000,
+	eCANNodeMax = 16,
+	eCANId_Sync = 0x080,
+	eCANId_Settings = 0x100,
+	eCANSyncLeadUS = 3000,
+	eCANSyncTimeoutUS = 500000,
+	eCANClockWindow = 32,
+	eCANSettingsQuietUS = 200000,
+	eCANSettingsChunkBytes = 7,
+
+	// An 8 byte standard frame with worst case stuffing, one bit is 1us at eCANBitRate
+	eCANFrameBits8 = 47 + 64 + (34 + 64 - 1) / 4,
+
+	// capacity_plan holds up the loop while it runs so the controller times a roofline worth of shards at most and sizes
+	//	a larger site from them, the limits keep the sizing math in 32 bits
+	eCapacityPlanShardMax = eCANNodeMax,
+	eCapacityPlanIcicleMax = 1 << 24,
+	eCapacityPlanLEDsPerIcicleMax = 1024,
+	eCapacityPlanFPSMax = 1000,
+	eCapacityPlanFrameMax = 300,
+
+	// What the static buffers have to leave of the board for the stack, the heap and the other modules
+	eBoardRAMReserveBytes = 4096,
+
+	// sim_verify runs dynamic ice from this seed with the default settings and checks the frame hash every interval
+	eSimSeed = 12345,
+	eSimCheckpointInterval = 100,
+	eSimCheckpointCount = 10,
+
+	// The golden hashes were taken with the 8x108x5 geometry, other geometries only check the time budget
+	eSimGoldenGeometry = eStripCount == 8 && eIciclesPerStrip == 108 && eLEDsPerIcicle == 5 && eSkippedLEDsPerStrip == 0,
+
+	eGaussianTable_GrowRate = 1 << 0,
+	eGaussianTable_PeekDepth = 1 << 1,
+	eGaussianTable_PeekDepthLifetime = 1 << 2,
+	eGaussianTable_DripStartTime = 1 << 3,
+	eGaussianTable_All = 0xF,
+};
+
+static_assert(eStreamUniverseCount <= 32, "every stream universe needs a bit in streamUniverseMask");
+
+static char const* gRenderModeStr[] = {"staticice", "dynamicice", "allon", "alloff", "festive", "stand", "playback", "stream"};
+
+static char const* gFramePacingStr[] = {"fixed", "adaptive"};
+static char const* gParamApplyStr[] = {"reset", "lazy"};
+
+enum
+{
+	eSettingsField_Float,
+
+	// A uint8_t color channel set and shown as 0.0 -> 1.0
+	eSettingsField_Color,
+	eSettingsField_UInt8,
+	eSettingsField_UInt16,
+	eSettingsField_UInt32,
+
+	// A uint8_t index into names
+	eSettingsField_Enum,
 };
 
-static char const* gRenderModeStr[] = {"staticice", "dynamicice", "allon", "alloff", "festive", "stand"};
+// One settings field for settings_set and settings_get, values outside minValue -> maxValue are rejected
+struct SSettingsField
+{
+	char const*			key;
+	uint8_t				type;
+	uint8_t				offset;
+	float				minValue;
+	float				maxValue;
+	char const* const*	names;
+
+	// Set for the fields that say which controller this is, settings_get leaves them out and blobs don't change them
+	//	so that settings copied from one controller to another don't make it a second copy of the first
+	bool				local;
+};
 
 struct SColorEntry
 {
@@ -92,451 +362,5451 @@ SColorEntry	gColorTable[8] =
 	{1.0f, 0.5f, 0.25f},
 };
 
-DMAMEM int		gIcicleLEDDisplayMemory[eLEDsPerStrip * 6];
+// The standard normal distribution at the quantiles (k + 0.5) / 256 in 4.12 fixed point
+static int16_t const	gStandardNormal4dot12[256] =
+{
+	-11820, -10324, -9565, -9038, -8628, -8290, -8001, -7746, -7519, -7312, -7123, -6948, -6784, -6631, -6486, -6350,
+	-6219, -6095, -5977, -5863, -5753, -5647, -5545, -5447, -5351, -5258, -5168, -5080, -4995, -4912, -4830, -4751,
+	-4673, -4597, -4523, -4450, -4378, -4307, -4238, -4170, -4104, -4038, -3973, -3910, -3847, -3785, -3724, -3664,
+	-3604, -3545, -3487, -3430, -3374, -3318, -3262, -3207, -3153, -3100, -3046, -2994, -2942, -2890, -2839, -2788,
+	-2738, -2688, -2638, -2589, -2540, -2492, -2444, -2396, -2348, -2301, -2255, -2208, -2162, -2116, -2070, -2025,
+	-1979, -1935, -1890, -1845, -1801, -1757, -1713, -1669, -1626, -1583, -1539, -1497, -1454, -1411, -1369, -1326,
+	-1284, -1242, -1200, -1158, -1117, -1075, -1034, -992, -951, -910, -869, -828, -787, -746, -705, -665,
+	-624, -584, -543, -503, -462, -422, -382, -341, -301, -261, -221, -181, -140, -100, -60, -20,
+	20, 60, 100, 140, 181, 221, 261, 301, 341, 382, 422, 462, 503, 543, 584, 624,
+	665, 705, 746, 787, 828, 869, 910, 951, 992, 1034, 1075, 1117, 1158, 1200, 1242, 1284,
+	1326, 1369, 1411, 1454, 1497, 1539, 1583, 1626, 1669, 1713, 1757, 1801, 1845, 1890, 1935, 1979,
+	2025, 2070, 2116, 2162, 2208, 2255, 2301, 2348, 2396, 2444, 2492, 2540, 2589, 2638, 2688, 2738,
+	2788, 2839, 2890, 2942, 2994, 3046, 3100, 3153, 3207, 3262, 3318, 3374, 3430, 3487, 3545, 3604,
+	3664, 3724, 3785, 3847, 3910, 3973, 4038, 4104, 4170, 4238, 4307, 4378, 4450, 4523, 4597, 4673,
+	4751, 4830, 4912, 4995, 5080, 5168, 5258, 5351, 5447, 5545, 5647, 5753, 5863, 5977, 6095, 6219,
+	6350, 6486, 6631, 6784, 6948, 7123, 7312, 7519, 7746, 8001, 8290, 8628, 9038, 9565, 10324, 11820,
+};
 
-class CModule_Icicle : public CModule, public ICmdHandler, public IOutdoorLightingInterface, public IInternetHandler
+// The frame hash sim_verify expects after every eSimCheckpointInterval frames. Any change to the model, rendering or
+//	transpose that changes the output changes these, a change meant to alter the look needs new values from sim_verify
+static uint32_t const	gSimGoldenHash[eSimCheckpointCount] =
 {
-public:
-	
-	MModule_Declaration(CModule_Icicle)
+	0xf441df14, 0x7fa99fcb, 0x98940e5b, 0xd1b1448a, 0xedf4d6c0, 0x14ebb8f7, 0xd599d91f, 0x63f0d525, 0x609c0289, 0x7bcabd0e,
+};
 
-private:
-	
-	CModule_Icicle(
-		)
-	:
-		CModule(
-			sizeof(settings),
-			3,
-			&settings,
-			eUpdateTimeUS),
-		leds(eLEDsPerStrip, gIcicleLEDDisplayMemory, NULL, WS2811_RGB)
+struct SGaussianTable
+{
+	// Fill the table with the quantiles of a gaussian distribution converted to fixed point with inScale, this is the only place
+	//	floats are used so it is only called when the distribution changes
+	void
+	Build(
+		float	inMean,
+		float	inStdDev,
+		float	inScale,
+		int32_t	inMin,
+		int32_t	inMax)
 	{
-		IInternetDevice*		internetDevice = CModule_ESP8266::Include(5, &Serial1, eESP8266ResetPint);
-		IRealTimeDataProvider*	ds3234Provider = CreateDS3234Provider(10);
-		CModule_Loggly*			loggly = CModule_Loggly::Include("pergola2", "logs-01.loggly.com", "/inputs/XXX_YOUR_ID_HERE");
-		
-		CModule_RealTime::Include();
-		CModule_Internet::Include();
-		CModule_Command::Include();
-		CModule_OutdoorLightingControl::Include(this, eMotionSensorPin, eTransformerRelayPin, eToggleButtonPin, NULL);
-		
-		AddSysMsgHandler(loggly);
-		gInternetModule->Configure(internetDevice);
-		gRealTime->Configure(ds3234Provider, 24 * 60 * 60);
+		for(int i = 0; i < 256; ++i)
+		{
+			float	value = (inMean + inStdDev * float(gStandardNormal4dot12[i]) / float(1 << 12)) * inScale;
+			int32_t	fixed;
 
-		updateCumulatorUS = 0;
-		ledsOn = false;
+			if(value <= float(inMin))
+			{
+				fixed = inMin;
+			}
+			else if(value >= float(inMax))
+			{
+				fixed = inMax;
+			}
+			else
+			{
+				fixed = int32_t(value);
+			}
+
+			// Values beyond 16 bits wrap the same way the conversion from float to uint16_t did on the device
+			entry[i] = uint16_t(fixed);
+		}
 	}
 
-	virtual void
-	Setup(
-		void)
+	// The top 8 bits of inRandom pick the quantile and the next 8 bits interpolate toward the next one
+	uint16_t
+	Sample(
+		uint32_t	inRandom) const
 	{
-		// Instantiate the wireless networking device and configure it to server pages
-		gInternetModule->WebServer_Start(8080);
-		MInternetRegisterPage("/", CModule_Icicle::CommandHomePageHandler);
-		MInternetRegisterPage("/rendermode", CModule_Icicle::CommandRenderModePageHandler);
+		uint32_t	index = inRandom >> 24;
+		int32_t		frac8 = (inRandom >> 16) & 0xFF;
 
-		DynamicState_Reset();
+		if(index == 255)
+		{
+			return entry[255];
+		}
 
-		memset(gIcicleLEDDisplayMemory, 0, sizeof(gIcicleLEDDisplayMemory));
+		return uint16_t(entry[index] + ((int32_t(int16_t(entry[index + 1] - entry[index])) * frac8) >> 8));
+	}
 
-		MCommandRegister("grow_set", CModule_Icicle::GrowDistributionSet, "[mean] [std dev]: Set grow rate distribution");
-		MCommandRegister("depth_set", CModule_Icicle::PeekDepthDistributionSet, "[mean] [std dev]: Set peek depth distribution");
-		MCommandRegister("peekduration_set", CModule_Icicle::PeekDepthLifeDistributionSet, "[mean] [std dev]: Set the duration distribution at the peek depth");
-		MCommandRegister("driptime_set", CModule_Icicle::DripStartTimeDistributionSet, "[mean] [std dev]: Set the drip start distribution");
-		MCommandRegister("driprate_set", CModule_Icicle::DripRateSet, "[pre rate] [post rate]: Set the drip rate");
-		MCommandRegister("growcolor_set", CModule_Icicle::GrowDownColorSet, "[r] [g] [b]: Set the grow down color range 0.0 -> 1.0");
-		MCommandRegister("recedecolor_set", CModule_Icicle::RecedeUpColorSet, "[r] [g] [b]: Set the recede up color range 0.0 -> 1.0");
-		MCommandRegister("staticcolor_set", CModule_Icicle::StaticColorSet, "[r] [g] [b]: Set the static color range 0.0 -> 1.0");
-		MCommandRegister("staticintensity_set", CModule_Icicle::StaticIntensitySet, "[intensity]: Set the static intensity 0.0 -> 1.0");
-		MCommandRegister("rendermode_set", CModule_Icicle::RenderModeSet, ": Set the render mode");
+	uint16_t	entry[256];
+};
 
-		leds.begin();
+// Collects output in a fixed buffer, output past the end of the buffer is counted in totalBytes but dropped
+class CBufferOutputDirector : public IOutputDirector
+{
+public:
+
+	CBufferOutputDirector(
+		char*	inBuffer,
+		size_t	inSize)
+	:
+		buffer(inBuffer),
+		size(inSize),
+		length(0),
+		totalBytes(0),
+		writeCount(0)
+	{
+	}
+
+	virtual void
+	write(
+		char const*	inMsg,
+		size_t		inBytes)
+	{
+		size_t	copyBytes = inBytes < size - length ? inBytes : size - length;
 
-		for(int i = 0; i < eLEDsPerStrip * 8; ++i)
+		if(copyBytes > 0)
 		{
-			leds.setPixel(i, 0, 0, 0);
+			memcpy(buffer + length, inMsg, copyBytes);
+			length += copyBytes;
 		}
 
-		leds.show();
+		totalBytes += inBytes;
+		++writeCount;
 	}
 
-	void
-	DynamicState_Reset(
-		void)
+	char*		buffer;
+	size_t		size;
+	size_t		length;
+	uint32_t	totalBytes;
+	uint32_t	writeCount;
+};
+
+// The settings part of the home page, see CModule_Icicle::CommandHomePageHandler()
+static char	gHomePageCache[2048];
+
+// The settings are kept in a few rotating slots of EEPROM or, off the device, a simulated EEPROM in RAM
+class ISettingsStoreBackend
+{
+public:
+
+	virtual uint8_t
+	Read(
+		uint16_t	inAddress) = 0;
+
+	virtual void
+	Write(
+		uint16_t	inAddress,
+		uint8_t		inValue) = 0;
+};
+
+#if ICICLE_SIMULATED_EEPROM
+
+class CSettingsStoreRAM : public ISettingsStoreBackend
+{
+public:
+
+	CSettingsStoreRAM(
+		)
+	:
+		writeCount(0),
+		powerLossAfterWrites(0xFFFFFFFF)
 	{
-		for(int i = 0; i < eIcicleTotal; ++i)
+		// Erased EEPROM reads back as 0xFF
+		memset(memory, 0xFF, sizeof(memory));
+	}
+
+	virtual uint8_t
+	Read(
+		uint16_t	inAddress)
+	{
+		return memory[inAddress];
+	}
+
+	virtual void
+	Write(
+		uint16_t	inAddress,
+		uint8_t		inValue)
+	{
+		// Writes past powerLossAfterWrites are dropped as if the power went out part way through a flush
+		if(writeCount++ < powerLossAfterWrites)
 		{
-			icicles[i].SetInitialState(this);
+			memory[inAddress] = inValue;
 		}
 	}
 
-	void
-	CommandHomePageHandler(
-		IOutputDirector*	inOutput,
-		int					inParamCount,
-		char const**		inParamList)
-	{
-		// Send html via in Output to add to the command server home page served to clients
+	uint8_t		memory[eEEPROMSize];
+	uint32_t	writeCount;
+	uint32_t	powerLossAfterWrites;
+};
 
-		inOutput->printf("<table border=\"1\">");
-		inOutput->printf("<tr><th>Parameter</th><th>Value</th></tr>");
+static CSettingsStoreRAM	gSettingsStoreBackend;
 
-		// add render mode
-		inOutput->printf("<tr><td>RenderMode</td><td>%s</td></tr>", gRenderModeStr[settings.renderMode]);
+#else
 
-		// add grow rate
-		inOutput->printf("<tr><td>GrowRate</td><td>%2.2f %2.2f</td></tr>", settings.meanGrowRateLEDsPerSec, settings.stdGrowRateLEDsPerSec);
+class CSettingsStoreEEPROM : public ISettingsStoreBackend
+{
+public:
 
-		// add peek depth
-		inOutput->printf("<tr><td>PeekDepth</td><td>%2.2f %2.2f</td></tr>", settings.meanPeekDepth, settings.stdPeekDepth);
+	virtual uint8_t
+	Read(
+		uint16_t	inAddress)
+	{
+		return EEPROM.read(inAddress);
+	}
 
-		// add peek depth lifetime
-		inOutput->printf("<tr><td>PeekDepthLifetime</td><td>%2.2f %2.2f</td></tr>", settings.meanPeekDepthLifetimeSec, settings.stdPeekDepthLifetimeSec);
+	virtual void
+	Write(
+		uint16_t	inAddress,
+		uint8_t		inValue)
+	{
+		EEPROM.write(inAddress, inValue);
+	}
+};
 
-		// add drip time
-		inOutput->printf("<tr><td>DripTime</td><td>%2.2f %2.2f</td></tr>", settings.meanIcicleStartDripTime, settings.stdIcicleStartDripTime);
+static CSettingsStoreEEPROM	gSettingsStoreBackend;
 
-		// add drip rate PreIcicleEnd
-		inOutput->printf("<tr><td>DripRate PreIcicleEnd</td><td>%2.2f</td></tr>", settings.waterDripRatePreLEDsPerSec);
+#endif
 
-		// add drip rate PostIcicleEnd
-		inOutput->printf("<tr><td>DripRate PostIcicleEnd</td><td>%2.2f</td></tr>", settings.waterDripRatePostLEDsPerTick);
+// Recorded shows are written once from the start and then read back from anywhere
+class IShowStoreBackend
+{
+public:
 
-		// add grow down color
-		inOutput->printf("<tr><td>GrowDown Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.growDownColorR / 255.0f, (float)settings.growDownColorG / 255.0f, (float)settings.growDownColorB / 255.0f);
+	// Start a new show, the show that was there before is lost
+	virtual bool
+	Create(
+		void) = 0;
 
-		// add recede up color
-		inOutput->printf("<tr><td>RecedeUp Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.recedeUpColorR / 255.0f, (float)settings.recedeUpColorG / 255.0f, (float)settings.recedeUpColorB / 255.0f);
+	virtual bool
+	Append(
+		uint8_t const*	inData,
+		uint32_t		inBytes) = 0;
 
-		// add water drip color
-		inOutput->printf("<tr><td>WaterDrip Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.waterDripR / 255.0f, (float)settings.waterDripG / 255.0f, (float)settings.waterDripB / 255.0f);
+	// Finish the show so it can be read
+	virtual void
+	Close(
+		void) = 0;
+
+	// Returns how many bytes were read, fewer than inBytes past the end of the show
+	virtual uint32_t
+	Read(
+		uint32_t	inOffset,
+		void*		outData,
+		uint32_t	inBytes) = 0;
+
+	virtual uint32_t
+	Size(
+		void) = 0;
+};
 
-		// add static color
-		inOutput->printf("<tr><td>Static Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.staticR / 255.0f, (float)settings.staticG / 255.0f, (float)settings.staticB / 255.0f);
+#if ICICLE_SHOW_SD
 
-		// add static intensity
-		inOutput->printf("<tr><td>Static Intensity</td><td>%1.2f</td></tr>", settings.staticIntensity);
+class CShowStoreSD : public IShowStoreBackend
+{
+public:
 
-		inOutput->printf("</table>");
-		
-		inOutput->printf("<table><tr><td><form action=\"rendermode\"><fieldset><legend>Change Render Mode</legend>");
-		for(int i = 0; i < eRenderMode_Count; ++i)
-		{
-			inOutput->printf("<input type=\"radio\" name=\"rendermode\" value=\"%s\" %s>%s<br>", gRenderModeStr[i], settings.renderMode == i ? "Checked" : "", gRenderModeStr[i]);
-		}
-		inOutput->printf("<input type=\"submit\" value=\"Submit\">");
-		inOutput->printf("</fieldset></form></td></tr></table>");
+	CShowStoreSD(
+		)
+	:
+		started(false)
+	{
 	}
 
-	void
-	CommandRenderModePageHandler(
-		IOutputDirector*	inOutput,
-		int					inParamCount,
-		char const**		inParamList)
+	virtual bool
+	Create(
+		void)
 	{
-		if(inParamCount != 2 && strcmp(inParamList[0], "rendermode") != 0)
-		{
-			return;
-		}
-		int i;
-		for(i = 0; i < eRenderMode_Count; ++i)
+		if(Start() == false)
 		{
-			if (strcmp(inParamList[1], gRenderModeStr[i]) == 0)
-			{
-				settings.renderMode = (uint8_t)i;
-				break;
-			}
+			return false;
 		}
 
-		EEPROMSave();
+		file.close();
+		SD.remove("ICICLES.SHO");
+		file = SD.open("ICICLES.SHO", FILE_WRITE);
+
+		return file;
 	}
 
-	virtual void
-	LEDStateChange(
-		bool	inLEDsOn)
+	virtual bool
+	Append(
+		uint8_t const*	inData,
+		uint32_t		inBytes)
 	{
-		ledsOn = inLEDsOn;
+		return file.write(inData, inBytes) == inBytes;
 	}
 
 	virtual void
-	MotionSensorStateChange(
-		bool	inMotionSensorTriggered)
+	Close(
+		void)
 	{
-
+		file.close();
 	}
 
-	virtual void
-	PushButtonStateChange(
-		int	inToggleCount)
+	virtual uint32_t
+	Read(
+		uint32_t	inOffset,
+		void*		outData,
+		uint32_t	inBytes)
 	{
+		if(OpenRead() == false || file.seek(inOffset) == false)
+		{
+			return 0;
+		}
+
+		int	bytes = file.read(outData, inBytes);
 
+		return bytes > 0 ? uint32_t(bytes) : 0;
 	}
 
-	virtual void
-	TimeOfDayChange(
-		int	inTimeOfDay)
+	virtual uint32_t
+	Size(
+		void)
 	{
-
+		return OpenRead() ? uint32_t(file.size()) : 0;
 	}
 
-	uint8_t
-	GrowDistributionSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	bool
+	Start(
+		void)
 	{
-		MReturnOnError(inArgC != 3, eCmd_Failed);
+		if(started == false)
+		{
+			started = SD.begin(ICICLE_SHOW_SD_CS);
+		}
+
+		return started;
+	}
+
+	bool
+	OpenRead(
+		void)
+	{
+		if(file == false && Start())
+		{
+			file = SD.open("ICICLES.SHO", FILE_READ);
+		}
+
+		return file;
+	}
+
+	File	file;
+	bool	started;
+};
+
+static CShowStoreSD	gShowStoreBackend;
+
+#elif ICICLE_SHOW_RAM_BYTES == 0
+
+// There is nowhere to keep a show so recording fails and there is nothing to play back
+class CShowStoreNone : public IShowStoreBackend
+{
+public:
+
+	virtual bool
+	Create(
+		void)
+	{
+		return false;
+	}
+
+	virtual bool
+	Append(
+		uint8_t const*	inData,
+		uint32_t		inBytes)
+	{
+		return false;
+	}
+
+	virtual void
+	Close(
+		void)
+	{
+	}
+
+	virtual uint32_t
+	Read(
+		uint32_t	inOffset,
+		void*		outData,
+		uint32_t	inBytes)
+	{
+		return 0;
+	}
+
+	virtual uint32_t
+	Size(
+		void)
+	{
+		return 0;
+	}
+};
+
+static CShowStoreNone	gShowStoreBackend;
+
+#else
+
+class CShowStoreRAM : public IShowStoreBackend
+{
+public:
+
+	CShowStoreRAM(
+		)
+	:
+		size(0)
+	{
+	}
+
+	virtual bool
+	Create(
+		void)
+	{
+		size = 0;
+
+		return true;
+	}
+
+	virtual bool
+	Append(
+		uint8_t const*	inData,
+		uint32_t		inBytes)
+	{
+		if(inBytes > sizeof(memory) - size)
+		{
+			return false;
+		}
+
+		memcpy(memory + size, inData, inBytes);
+		size += inBytes;
+
+		return true;
+	}
+
+	virtual void
+	Close(
+		void)
+	{
+	}
+
+	virtual uint32_t
+	Read(
+		uint32_t	inOffset,
+		void*		outData,
+		uint32_t	inBytes)
+	{
+		if(inOffset >= size)
+		{
+			return 0;
+		}
+
+		uint32_t	bytes = inBytes < size - inOffset ? inBytes : size - inOffset;
+
+		memcpy(outData, memory + inOffset, bytes);
+
+		return bytes;
+	}
+
+	virtual uint32_t
+	Size(
+		void)
+	{
+		return size;
+	}
+
+	uint8_t		memory[ICICLE_SHOW_RAM_BYTES];
+	uint32_t	size;
+};
+
+static CShowStoreRAM	gShowStoreBackend;
+
+#endif
+
+// The controllers of a roofline talk over CAN, or off the device over a bus in RAM that every frame written to can be
+//	read back from
+class ICANBusBackend
+{
+public:
+
+	virtual void
+	Start(
+		void) = 0;
+
+	// Returns false if there is no room to send the frame right now
+	virtual bool
+	Write(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData) = 0;
+
+	// Returns false if no frame has arrived
+	virtual bool
+	Read(
+		uint16_t&	outId,
+		uint8_t&	outLength,
+		uint8_t*	outData) = 0;
+};
+
+#if !ICICLE_CAN
+
+// There is no bus so nothing is ever sent or received
+class CCANBusNone : public ICANBusBackend
+{
+public:
+
+	virtual void
+	Start(
+		void)
+	{
+	}
+
+	virtual bool
+	Write(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		return false;
+	}
+
+	virtual bool
+	Read(
+		uint16_t&	outId,
+		uint8_t&	outLength,
+		uint8_t*	outData)
+	{
+		return false;
+	}
+};
+
+static CCANBusNone	gCANBusBackend;
+
+#elif ICICLE_SIMULATED_CAN
+
+class CCANBusRAM : public ICANBusBackend
+{
+public:
+
+	enum
+	{
+		eFrameMax = 64,
+	};
+
+	CCANBusRAM(
+		)
+	:
+		head(0),
+		tail(0)
+	{
+	}
+
+	virtual void
+	Start(
+		void)
+	{
+		head = tail = 0;
+	}
+
+	virtual bool
+	Write(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		if(tail - head >= eFrameMax)
+		{
+			return false;
+		}
+
+		SFrame&	frame = frames[tail++ % eFrameMax];
+
+		frame.id = inId;
+		frame.length = inLength;
+		memcpy(frame.data, inData, inLength);
+
+		return true;
+	}
+
+	virtual bool
+	Read(
+		uint16_t&	outId,
+		uint8_t&	outLength,
+		uint8_t*	outData)
+	{
+		if(head == tail)
+		{
+			return false;
+		}
+
+		SFrame const&	frame = frames[head++ % eFrameMax];
+
+		outId = frame.id;
+		outLength = frame.length;
+		memcpy(outData, frame.data, frame.length);
+
+		return true;
+	}
+
+	struct SFrame
+	{
+		uint16_t	id;
+		uint8_t		length;
+		uint8_t		data[8];
+	};
+
+	SFrame		frames[eFrameMax];
+	uint32_t	head;
+	uint32_t	tail;
+};
+
+static CCANBusRAM	gCANBusBackend;
+
+#else
+
+class CCANBusFlexCAN : public ICANBusBackend
+{
+public:
+
+	CCANBusFlexCAN(
+		)
+	:
+		bus(eCANBitRate)
+	{
+	}
+
+	virtual void
+	Start(
+		void)
+	{
+		bus.begin();
+	}
+
+	virtual bool
+	Write(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		CAN_message_t	message;
+
+		memset(&message, 0, sizeof(message));
+		message.id = inId;
+		message.len = inLength;
+		memcpy(message.buf, inData, inLength);
+
+		return bus.write(message) != 0;
+	}
+
+	virtual bool
+	Read(
+		uint16_t&	outId,
+		uint8_t&	outLength,
+		uint8_t*	outData)
+	{
+		CAN_message_t	message;
+
+		if(bus.available() == 0 || bus.read(message) == 0)
+		{
+			return false;
+		}
+
+		outId = uint16_t(message.id);
+		outLength = message.len <= 8 ? message.len : 8;
+		memcpy(outData, message.buf, outLength);
+
+		return true;
+	}
+
+	FlexCAN	bus;
+};
+
+static CCANBusFlexCAN	gCANBusBackend;
+
+#endif
+
+// Followers track the offset of their clock from the clock of node 0. The offset seen by a sync is the real offset plus
+//	the time the message spent on the bus and waiting to be read, the smallest over a window of syncs waited the least
+struct SCANClockSync
+{
+	void
+	Reset(
+		void)
+	{
+		count = 0;
+		next = 0;
+	}
+
+	// Add the local receive time minus the master send time of a sync and return the best estimate of the offset
+	uint32_t
+	Add(
+		uint32_t	inOffsetUS)
+	{
+		samples[next] = inOffsetUS;
+		next = uint8_t((next + 1) % eCANClockWindow);
+		if(count < eCANClockWindow)
+		{
+			++count;
+		}
+
+		uint32_t	minOffsetUS = inOffsetUS;
+
+		for(int i = 0; i < count; ++i)
+		{
+			if(int32_t(samples[i] - minOffsetUS) < 0)
+			{
+				minOffsetUS = samples[i];
+			}
+		}
+
+		return minOffsetUS - eCANFrameBits8;
+	}
+
+	// How far apart the delays in the window are, the worst that the offset can be off by while the window fills
+	uint32_t
+	Spread(
+		void)
+	{
+		uint32_t	spreadUS = 0;
+
+		for(int i = 0; i < count; ++i)
+		{
+			for(int j = 0; j < count; ++j)
+			{
+				if(int32_t(samples[i] - samples[j]) > int32_t(spreadUS))
+				{
+					spreadUS = samples[i] - samples[j];
+				}
+			}
+		}
+
+		return spreadUS;
+	}
+
+	uint32_t	samples[eCANClockWindow];
+	uint8_t		count;
+	uint8_t		next;
+};
+
+// The settings are broadcast as their slot image cut into chunks, the first byte of each frame is the chunk index
+struct SCANSettingsAssembly
+{
+	void
+	Reset(
+		void)
+	{
+		senderId = 0;
+		nextChunk = 0;
+	}
+
+	// Returns true when the last chunk of an image has arrived, chunks out of order drop the image until the next first chunk
+	bool
+	Add(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData,
+		uint8_t*		ioImage,
+		uint32_t		inImageBytes)
+	{
+		if(inLength < 2 || (inData[0] != 0 && (inId != senderId || inData[0] != nextChunk)))
+		{
+			nextChunk = 0xFF;
+			return false;
+		}
+
+		uint32_t	offset = uint32_t(inData[0]) * eCANSettingsChunkBytes;
+
+		if(offset >= inImageBytes)
+		{
+			nextChunk = 0xFF;
+			return false;
+		}
+
+		uint32_t	bytes = uint32_t(inLength - 1) < inImageBytes - offset ? uint32_t(inLength - 1) : inImageBytes - offset;
+
+		senderId = inId;
+		nextChunk = uint8_t(inData[0] + 1);
+		memcpy(ioImage + offset, inData + 1, bytes);
+
+		return offset + bytes == inImageBytes;
+	}
+
+	uint16_t	senderId;
+	uint8_t		nextChunk;
+};
+
+// The header of each settings slot, the crc covers the rest of the header and the settings after it
+struct SSettingsSlotHeader
+{
+	uint32_t	sequence;
+	uint8_t		version;
+	uint8_t		size;
+	uint16_t	crc;
+};
+
+static uint16_t
+SettingsStore_CRC(
+	uint8_t const*	inData,
+	size_t			inSize,
+	uint16_t		inCRC)
+{
+	// CRC-16/CCITT
+	for(size_t i = 0; i < inSize; ++i)
+	{
+		inCRC ^= uint16_t(inData[i]) << 8;
+		for(int j = 0; j < 8; ++j)
+		{
+			inCRC = (inCRC & 0x8000) ? uint16_t((inCRC << 1) ^ 0x1021) : uint16_t(inCRC << 1);
+		}
+	}
+
+	return inCRC;
+}
+
+
+struct SLEDLayout
+{
+	// Every other icicle is wired from the bottom back up to the top
+	bool	serpentine;
+
+	// Bit n set means the icicles on strip n are wired from the far end of the strip
+	uint8_t	stripReverseMask;
+};
+
+static SLEDLayout const	gLEDLayout = {true, 0x00};
+
+// Physical LEDs that do not belong to any icicle and stay dark, as strip * eLEDsPerStrip + offset in ascending order.
+//	Each strip must list exactly eSkippedLEDsPerStrip entries and they have to fall between icicles, the list ends
+//	with 0xFFFF
+static uint16_t const	gSkippedLEDs[eSkippedLEDsPerStrip * eStripCount + 1] = {0xFFFF};
+
+enum
+{
+	eIcicleLEDMap_Reversed = 0x8000,
+};
+
+// The physical LED index of the top LED of each icicle. The LEDs of an icicle are next to each other on its strip, going
+//	down from the top or up when eIcicleLEDMap_Reversed is set, so one entry an icicle is enough
+uint16_t	gIcicleLEDMap[eIcicleTotal];
+
+// The physical LED index of the LED inDepth down the icicle of inMapEntry
+static inline uint32_t
+IcicleLEDMap_LED(
+	uint16_t	inMapEntry,
+	uint32_t	inDepth)
+{
+	return (inMapEntry & eIcicleLEDMap_Reversed) ? (inMapEntry & ~eIcicleLEDMap_Reversed) - inDepth : inMapEntry + inDepth;
+}
+
+// What capacity_plan measured over a set of shards, the shards of one site can be split up and their timings added
+struct SCapacityTiming
+{
+	uint32_t	shards;
+	uint32_t	updateUS;
+	uint32_t	renderUS;
+	uint32_t	transposeUS;
+	uint32_t	shardMaxUS;
+};
+
+#if ICICLE_PERF_STATS
+
+enum
+{
+	ePerfPhase_UpdateModel,
+
+	// One phase per render mode in render mode order
+	ePerfPhase_Render,
+	ePerfPhase_RenderDirty = ePerfPhase_Render + eRenderMode_Count,
+	ePerfPhase_Transpose,
+	ePerfPhase_DMAWait,
+	ePerfPhase_Show,
+	ePerfPhase_Count,
+
+	ePerfBucketCount = 32,
+};
+
+static char const* gPerfPhaseStr[] = {"updatemodel", "staticice", "dynamicice", "allon", "alloff", "festive", "stand", "playback", "dynamicdirty", "transpose", "dmawait", "show"};
+
+#if defined(__arm__)
+	#define MPerfCycles() ARM_DWT_CYCCNT
+	#define MPerfCyclesPerUS (F_CPU / 1000000)
+#else
+	#define MPerfCycles() micros()
+	#define MPerfCyclesPerUS 1
+#endif
+
+#define MPerfStart(inStart) uint32_t inStart = MPerfCycles()
+#define MPerfEnd(inPhase, inStart) perfStats[inPhase].Add(MPerfCycles() - inStart)
+
+// Cycle counts binned by their highest set bit so adding a sample is a handful of instructions
+struct SPerfHistogram
+{
+	void
+	Reset(
+		void)
+	{
+		memset(this, 0, sizeof(*this));
+		minCycles = 0xFFFFFFFF;
+	}
+
+	inline void
+	Add(
+		uint32_t	inCycles)
+	{
+		++bucket[31 - __builtin_clz(inCycles | 1)];
+		++count;
+		totalCycles += inCycles;
+		if(inCycles < minCycles)
+		{
+			minCycles = inCycles;
+		}
+		if(inCycles > maxCycles)
+		{
+			maxCycles = inCycles;
+		}
+	}
+
+	// The upper edge of the bucket holding the 99th percentile sample, never more than the max
+	uint32_t
+	GetP99Cycles(
+		void) const
+	{
+		uint32_t	remaining = count - count * 99 / 100;
+
+		for(int i = ePerfBucketCount - 1; i >= 0; --i)
+		{
+			if(bucket[i] >= remaining)
+			{
+				uint32_t	edge = i >= 31 ? 0xFFFFFFFF : (2UL << i) - 1;
+
+				return edge < maxCycles ? edge : maxCycles;
+			}
+			remaining -= bucket[i];
+		}
+
+		return maxCycles;
+	}
+
+	uint32_t	bucket[ePerfBucketCount];
+	uint32_t	count;
+	uint32_t	minCycles;
+	uint32_t	maxCycles;
+	uint64_t	totalCycles;
+};
+
+#else
+
+#define MPerfStart(inStart)
+#define MPerfEnd(inPhase, inStart)
+
+#endif
+
+#if ICICLE_SIMD && defined(__ARM_ARCH_7EM__)
+
+// Cortex-M4 DSP instructions for the icicle update kernel, each word holds two 16 bit lanes with the lower index in the low half
+
+static inline uint32_t
+DSP_UAdd16(
+	uint32_t	inA,
+	uint32_t	inB)
+{
+	uint32_t	result;
+
+	asm("uadd16 %0, %1, %2" : "=r" (result) : "r" (inA), "r" (inB));
+
+	return result;
+}
+
+// Returns 0xFFFF in each lane where inA >= inB as signed values
+static inline uint32_t
+DSP_SGEMask16(
+	uint32_t	inA,
+	uint32_t	inB)
+{
+	uint32_t	result;
+
+	asm("ssub16 %0, %1, %2\n\tsel %0, %3, %4" : "=&r" (result) : "r" (inA), "r" (inB), "r" (0xFFFFFFFF), "r" (0) : "cc");
+
+	return result;
+}
+
+#endif
+
+DMAMEM int		gIcicleLEDDisplayMemory[SInstallGeometry::eDMABytes / sizeof(int)];
+
+#if ICICLE_DRAW_BUFFER
+// FrameTranspose() writes here while the previous frame is still being sent out of gIcicleLEDDisplayMemory, leds.show() copies it over
+DMAMEM int		gIcicleLEDDrawMemory[SInstallGeometry::eDMABytes / sizeof(int)];
+#else
+// Without a draw buffer the frames are drawn into the display memory once the DMA is done with it, see FrameDMA_Wait()
+int				(&gIcicleLEDDrawMemory)[SInstallGeometry::eDMABytes / sizeof(int)] = gIcicleLEDDisplayMemory;
+#endif
+
+static_assert(sizeof(gIcicleLEDDisplayMemory) == SInstallGeometry::eDMABytes && sizeof(gIcicleLEDDrawMemory) == SInstallGeometry::eDMABytes, "OctoWS2811 needs 24 bytes per LED of a strip");
+
+// The render modes draw linear RGB into one row per strip, FrameTranspose() converts it to the OctoWS2811 DMA layout
+uint8_t		gIcicleLEDFrame[eStripCount][eLEDsPerStrip * 3];
+
+enum
+{
+	eFrameBufferBytes = sizeof(gIcicleLEDFrame) + sizeof(gIcicleLEDDisplayMemory) + ICICLE_DRAW_BUFFER * sizeof(gIcicleLEDDrawMemory) + sizeof(gIcicleLEDMap),
+};
+
+// Calls ioOp(0) to ioOp(tCount - 1) unrolled at compile time, an -Os build never unrolls a loop by itself
+template<int tCount>
+struct SUnroll
+{
+	template<typename tOp>
+	static inline __attribute__((always_inline)) void
+	Run(
+		tOp&	ioOp)
+	{
+		SUnroll<tCount - 1>::Run(ioOp);
+		ioOp(tCount - 1);
+	}
+};
+
+template<>
+struct SUnroll<0>
+{
+	template<typename tOp>
+	static inline void
+	Run(
+		tOp&	ioOp)
+	{
+	}
+};
+
+// What it takes to draw one dynamic icicle, worked out from its state once for all of its LEDs
+struct SIcicleDraw
+{
+	uint32_t		depthMag;
+	uint32_t		depthFrac8;
+	uint32_t		dripAMag;
+	uint32_t		dripBMag;
+	uint32_t		dripAFrac8;
+	uint32_t		dripBFrac8;
+	uint16_t const*	iceColor8dot8;
+	uint16_t const*	dripColorA8dot8;
+	uint16_t const*	dripColorB8dot8;
+};
+
+// The render and transpose kernels of a geometry, every loop over the LEDs of an icicle or the strips of the DMA
+//	buffer has a compile time length
+template<typename tGeometry>
+struct SIcicleKernels
+{
+	struct SIcicleLEDOp
+	{
+		inline __attribute__((always_inline)) void
+		operator()(
+			uint32_t	inLED)
+		{
+			SIcicleDraw const&	draw = *drawState;
+			uint32_t			r8dot8, g8dot8, b8dot8;
+
+			if(inLED <= draw.depthMag)
+			{
+				// The LED is within the icicle
+				r8dot8 = draw.iceColor8dot8[0];
+				g8dot8 = draw.iceColor8dot8[1];
+				b8dot8 = draw.iceColor8dot8[2];
+
+				if(inLED == draw.depthMag)
+				{
+					r8dot8 = (r8dot8 * draw.depthFrac8) >> 8;
+					g8dot8 = (g8dot8 * draw.depthFrac8) >> 8;
+					b8dot8 = (b8dot8 * draw.depthFrac8) >> 8;
+				}
+
+				if(inLED == draw.dripAMag)
+				{
+					r8dot8 = ((r8dot8 * (0x100 - draw.dripAFrac8)) >> 8) + draw.dripColorA8dot8[0];
+					g8dot8 = ((g8dot8 * (0x100 - draw.dripAFrac8)) >> 8) + draw.dripColorA8dot8[1];
+					b8dot8 = ((b8dot8 * (0x100 - draw.dripAFrac8)) >> 8) + draw.dripColorA8dot8[2];
+				}
+				else if(inLED == draw.dripBMag)
+				{
+					r8dot8 = ((r8dot8 * (0x100 - draw.dripBFrac8)) >> 8) + draw.dripColorB8dot8[0];
+					g8dot8 = ((g8dot8 * (0x100 - draw.dripBFrac8)) >> 8) + draw.dripColorB8dot8[1];
+					b8dot8 = ((b8dot8 * (0x100 - draw.dripBFrac8)) >> 8) + draw.dripColorB8dot8[2];
+				}
+			}
+			else
+			{
+				// The LED is past the end of the icicle
+				r8dot8 = g8dot8 = b8dot8 = 0;
+			}
+
+			if(r8dot8 > 0xFFFF) r8dot8 = 0xFFFF;
+			if(g8dot8 > 0xFFFF) g8dot8 = 0xFFFF;
+			if(b8dot8 > 0xFFFF) b8dot8 = 0xFFFF;
+
+			int32_t	led = topLED + int32_t(inLED) * step;
+
+			MAssert(led >= 0 && led < tGeometry::eLEDsPerStrip * tGeometry::eStripCount);
+
+			// The strip rows are contiguous so the physical LED index addresses the whole frame
+			uint8_t*	rgb = frame + led * 3;
+
+			rgb[0] = uint8_t(r8dot8 >> 8);
+			rgb[1] = uint8_t(g8dot8 >> 8);
+			rgb[2] = uint8_t(b8dot8 >> 8);
+		}
+
+		SIcicleDraw const*	drawState;
+		int32_t				topLED;
+		int32_t				step;
+		uint8_t*			frame;
+	};
+
+	// Draw one icicle into the strip rows at ioFrame, inLEDMapEntry is its entry of the LED map
+	static inline void
+	RenderIcicle(
+		SIcicleDraw const&	inDraw,
+		uint16_t			inLEDMapEntry,
+		uint8_t*			ioFrame)
+	{
+		SIcicleLEDOp	op = {&inDraw, int32_t(IcicleLEDMap_LED(inLEDMapEntry, 0)), (inLEDMapEntry & eIcicleLEDMap_Reversed) ? -1 : 1, ioFrame};
+
+		SUnroll<tGeometry::eLEDsPerIcicle>::Run(op);
+	}
+
+	// Strip row n, or nothing past the strips of the geometry
+	template<bool tApplyOutputLUT>
+	static inline uint32_t
+	Lane(
+		uint8_t const	(*inFrame)[tGeometry::eLEDsPerStrip * 3],
+		uint8_t const*	inLUT,
+		int				inStrip,
+		int				inByte)
+	{
+		if(inStrip >= tGeometry::eStripCount)
+		{
+			return 0;
+		}
+
+		return tApplyOutputLUT ? inLUT[inFrame[inStrip][inByte]] : inFrame[inStrip][inByte];
+	}
+
+	// OctoWS2811 sends one byte per color bit, bit n of each byte belongs to strip n and the 24 bytes of an LED are its
+	//	WS2811_RGB color from the msb down. So for each color channel the 8 strip bytes are an 8x8 bit matrix that is
+	//	transposed and stored in reverse byte order
+	template<bool tApplyOutputLUT>
+	static void
+	Transpose(
+		uint8_t const	(*inFrame)[tGeometry::eLEDsPerStrip * 3],
+		uint8_t const	(*inOutputLUT)[256],
+		uint32_t*		outDMA)
+	{
+		for(int i = 0; i < tGeometry::eLEDsPerStrip * 3; i += 3)
+		{
+			for(int c = 0; c < 3; ++c, outDMA += 2)
+			{
+				uint8_t const*	lut = tApplyOutputLUT ? inOutputLUT[c] : NULL;
+				uint32_t		x, y, t;
+
+				x = Lane<tApplyOutputLUT>(inFrame, lut, 0, i + c) | (Lane<tApplyOutputLUT>(inFrame, lut, 1, i + c) << 8) | (Lane<tApplyOutputLUT>(inFrame, lut, 2, i + c) << 16) | (Lane<tApplyOutputLUT>(inFrame, lut, 3, i + c) << 24);
+				y = Lane<tApplyOutputLUT>(inFrame, lut, 4, i + c) | (Lane<tApplyOutputLUT>(inFrame, lut, 5, i + c) << 8) | (Lane<tApplyOutputLUT>(inFrame, lut, 6, i + c) << 16) | (Lane<tApplyOutputLUT>(inFrame, lut, 7, i + c) << 24);
+
+				// Swap bits within 2x2, then 4x4 blocks of each 32 bit half, then the 4x4 blocks across the halves
+				t = (x ^ (x >> 7)) & 0x00AA00AA; x ^= t ^ (t << 7);
+				t = (y ^ (y >> 7)) & 0x00AA00AA; y ^= t ^ (t << 7);
+				t = (x ^ (x >> 14)) & 0x0000CCCC; x ^= t ^ (t << 14);
+				t = (y ^ (y >> 14)) & 0x0000CCCC; y ^= t ^ (t << 14);
+				t = ((x >> 4) ^ y) & 0x0F0F0F0F; y ^= t; x ^= t << 4;
+
+				// Byte n of x/y now holds bit n of every strip, the msb goes out first
+				outDMA[0] = __builtin_bswap32(y);
+				outDMA[1] = __builtin_bswap32(x);
+			}
+		}
+	}
+};
+
+// IcicleStream_Receive() hands packets to the module through this
+class CModule_Icicle;
+static CModule_Icicle*	gIcicleModule;
+
+class CModule_Icicle : public CModule, public ICmdHandler, public IOutdoorLightingInterface, public IInternetHandler
+{
+public:
+	
+	MModule_Declaration(CModule_Icicle)
+
+	// Decode one Art-Net packet from whatever transport receives them. The ArtDmx data is copied straight into the strip
+	//	rows and the frame goes out on the next update once every universe has arrived, or on an ArtSync once the sender
+	//	has sent one. Nothing here waits on the LEDs so it is safe to call from the transport
+	void
+	Stream_Receive(
+		uint8_t const*	inPacket,
+		uint32_t		inBytes)
+	{
+		if(ledsOn == false)
+		{
+			return;
+		}
+
+		if(inBytes < 10 || memcmp(inPacket, "Art-Net", 8) != 0)
+		{
+			++streamBadPacketCount;
+			return;
+		}
+
+		uint32_t	opCode = inPacket[8] | (inPacket[9] << 8);
+
+		if(opCode == eStreamOpCode_Sync)
+		{
+			streamSyncSeen = true;
+			if(streamUniverseMask != 0)
+			{
+				Stream_FrameComplete();
+			}
+			return;
+		}
+
+		if(opCode != eStreamOpCode_Dmx || inBytes < eStreamHeaderSize)
+		{
+			++streamBadPacketCount;
+			return;
+		}
+
+		uint32_t	universe = uint32_t(inPacket[14] | (inPacket[15] << 8)) - Stream_FirstUniverse();
+		uint32_t	length = (inPacket[16] << 8) | inPacket[17];
+
+		if(universe >= eStreamUniverseCount || length > inBytes - eStreamHeaderSize)
+		{
+			++streamBadPacketCount;
+			return;
+		}
+
+		// Only Update() shows frames, so a packet that beats it to a complete frame is dropped rather than tearing it
+		if(streamFrameReady)
+		{
+			++streamOverrunCount;
+			return;
+		}
+
+		uint32_t	firstLED = (universe % eStreamUniversesPerStrip) * eStreamLEDsPerUniverse;
+		uint32_t	maxBytes = (eLEDsPerStrip - firstLED < eStreamLEDsPerUniverse ? eLEDsPerStrip - firstLED : eStreamLEDsPerUniverse) * 3;
+
+		memcpy(gIcicleLEDFrame[universe / eStreamUniversesPerStrip] + firstLED * 3, inPacket + eStreamHeaderSize, length < maxBytes ? length : maxBytes);
+
+		// The rows no longer hold what the set mode drew even if the stream never gets as far as showing a frame
+		frameInvalid = true;
+		streamUniverseMask |= 1UL << universe;
+		streamLastPacketUS = micros();
+		++streamPacketCount;
+
+		if(streamActive == false)
+		{
+			streamActive = true;
+			++streamStartCount;
+		}
+
+		if(streamSyncSeen == false && streamUniverseMask == (0xFFFFFFFF >> (32 - eStreamUniverseCount)))
+		{
+			Stream_FrameComplete();
+		}
+	}
+
+	// The frame buffers and backends are globals outside of the module, the stack, heap and the other modules have to
+	//	fit in what is left of the board
+	static constexpr uint32_t
+	StaticBytes(
+		void)
+	{
+		return sizeof(CModule_Icicle) + eFrameBufferBytes + sizeof(gHomePageCache) + sizeof(gShowStoreBackend) + sizeof(gCANBusBackend);
+	}
+
+private:
+
+#if defined(ICICLE_HOST_TEST)
+	// The host tests in host/IcicleHostTest.cpp look at the frame and model state directly
+	friend struct SIcicleHostTest;
+#endif
+
+#if defined(WIN32)
+	// host/IciclePlan.cpp splits the capacity plan shards between worker processes
+	friend struct SIcicleHostPlan;
+#endif
+
+	// Defined with the rest of the module state further down
+	struct SSettings;
+	
+	CModule_Icicle(
+		)
+	:
+		CModule(
+			0,
+			0,
+			NULL,
+			eUpdateTimeUS),
+		leds(eLEDsPerStrip, gIcicleLEDDisplayMemory, gIcicleLEDDrawMemory, WS2811_RGB)
+	{
+		IInternetDevice*		internetDevice = CModule_ESP8266::Include(5, &Serial1, eESP8266ResetPint);
+		IRealTimeDataProvider*	ds3234Provider = CreateDS3234Provider(10);
+		CModule_Loggly*			loggly = CModule_Loggly::Include("pergola2", "logs-01.loggly.com", "/inputs/XXX_YOUR_ID_HERE");
+		
+		CModule_RealTime::Include();
+		CModule_Internet::Include();
+		CModule_Command::Include();
+		CModule_OutdoorLightingControl::Include(this, eMotionSensorPin, eTransformerRelayPin, eToggleButtonPin, NULL);
+		
+		AddSysMsgHandler(loggly);
+		gInternetModule->Configure(internetDevice);
+		gRealTime->Configure(ds3234Provider, 24 * 60 * 60);
+
+		updateCumulatorUS = 0;
+		ledsOn = false;
+		renderedMode = 0xFF;
+		frameInvalid = true;
+		memset(dirtyIcicles, 0, sizeof(dirtyIcicles));
+		dirtyIcicleCount = 0;
+		dirtyFrameCount = 0;
+		skippedShowCount = 0;
+		frameReady = false;
+		framesSentCount = 0;
+		dmaWaitCount = 0;
+		dmaWaitTotalUS = 0;
+		dmaWaitMaxUS = 0;
+		frameDMAWaitUS = 0;
+		frameElapsedUS = 0;
+		frameIntervalUS = eFrameIntervalDefaultUS;
+		FramePacing_ResetStats();
+		PerfStats_Reset();
+		homePageValid = false;
+		homePageLength = 0;
+		settingsDirty = false;
+		settingsFlushing = false;
+		settingsChangedUS = 0;
+		settingsSlot = 0;
+		settingsSequence = 0;
+		settingsSaveCount = 0;
+		settingsFlushCount = 0;
+		settingsBytesWritten = 0;
+		lastUpdateUS = 0;
+		webYieldedUS = 0;
+		webYieldCount = 0;
+		frameLastStartUS = 0;
+		reseedTables = 0;
+		reseedRemaining = 0;
+		reseedCursor = 0;
+		streamActive = false;
+		streamSyncSeen = false;
+		streamFrameReady = false;
+		streamUniverseMask = 0;
+		streamLastPacketUS = 0;
+		streamFrameCompleteUS = 0;
+		Stream_ResetStats();
+		showRecording = false;
+		showOpen = false;
+		showChecked = false;
+		showScanning = false;
+		showChunkStart = 0;
+		showChunkLength = 0;
+		canSettingsPending = false;
+		canSettingsFromBus = false;
+		canSettingsChunk = 0;
+		CAN_Reset();
+		CAN_ResetStats();
+
+		gIcicleModule = this;
+	}
+
+	virtual void
+	Setup(
+		void)
+	{
+		// Instantiate the wireless networking device and configure it to server pages
+		gInternetModule->WebServer_Start(8080);
+		MInternetRegisterPage("/", CModule_Icicle::CommandHomePageHandler);
+		MInternetRegisterPage("/rendermode", CModule_Icicle::CommandRenderModePageHandler);
+		MInternetRegisterPage("/settings", CModule_Icicle::CommandSettingsPageHandler);
+
+		SettingsStore_Load();
+
+		LayoutBuild();
+		GaussianTables_Build(eGaussianTable_All);
+		DynamicPalette_Build();
+		GammaLUT_Build();
+		RandomSeed(micros());
+		DynamicState_Reset();
+		FramePacing_Apply();
+
+		memset(gIcicleLEDDisplayMemory, 0, sizeof(gIcicleLEDDisplayMemory));
+		memset(gIcicleLEDDrawMemory, 0, sizeof(gIcicleLEDDrawMemory));
+		memset(gIcicleLEDFrame, 0, sizeof(gIcicleLEDFrame));
+
+		MCommandRegister("grow_set", CModule_Icicle::GrowDistributionSet, "[mean] [std dev]: Set grow rate distribution");
+		MCommandRegister("depth_set", CModule_Icicle::PeekDepthDistributionSet, "[mean] [std dev]: Set peek depth distribution");
+		MCommandRegister("peekduration_set", CModule_Icicle::PeekDepthLifeDistributionSet, "[mean] [std dev]: Set the duration distribution at the peek depth");
+		MCommandRegister("driptime_set", CModule_Icicle::DripStartTimeDistributionSet, "[mean] [std dev]: Set the drip start distribution");
+		MCommandRegister("driprate_set", CModule_Icicle::DripRateSet, "[pre rate] [post rate]: Set the drip rate");
+		MCommandRegister("growcolor_set", CModule_Icicle::GrowDownColorSet, "[r] [g] [b]: Set the grow down color range 0.0 -> 1.0");
+		MCommandRegister("recedecolor_set", CModule_Icicle::RecedeUpColorSet, "[r] [g] [b]: Set the recede up color range 0.0 -> 1.0");
+		MCommandRegister("staticcolor_set", CModule_Icicle::StaticColorSet, "[r] [g] [b]: Set the static color range 0.0 -> 1.0");
+		MCommandRegister("staticintensity_set", CModule_Icicle::StaticIntensitySet, "[intensity]: Set the static intensity 0.0 -> 1.0");
+		MCommandRegister("gamma_set", CModule_Icicle::GammaSet, "[gamma] or [r] [g] [b]: Set the output gamma, 1.0 is linear");
+		MCommandRegister("rendermode_set", CModule_Icicle::RenderModeSet, ": Set the render mode");
+		MCommandRegister("randomseed_set", CModule_Icicle::RandomSeedSet, "[seed]: Restart dynamic ice from the given random seed");
+		MCommandRegister("render_bench", CModule_Icicle::RenderBench, "[frames]: Time each render mode and leds.show()");
+		MCommandRegister("geometry_bench", CModule_Icicle::GeometryBench, "[frames]: Time the render and transpose kernels built for other icicle lengths and strip counts");
+		MCommandRegister("dirty_stats", CModule_Icicle::DirtyStats, "[reset]: Show the ratio of icicles redrawn by dynamic ice");
+		MCommandRegister("dma_stats", CModule_Icicle::DMAStats, "[reset]: Show how long frames waited for the previous DMA transfer");
+		MCommandRegister("frame_verify", CModule_Icicle::FrameVerify, ": Check FrameTranspose() against OctoWS2811::getPixel()");
+		MCommandRegister("framepacing_set", CModule_Icicle::FramePacingSet, "[fixed|adaptive] [interval us] [budget %]: Set how frames are paced, adaptive never goes slower than the interval");
+		MCommandRegister("framepacing_stats", CModule_Icicle::FramePacingStats, "[reset]: Show the achieved frame rate and missed deadlines");
+		MCommandRegister("perf_stats", CModule_Icicle::PerfStats, "[reset]: Show how long each phase of a frame takes");
+		MCommandRegister("settings_store", CModule_Icicle::SettingsStore, "[flush]: Show the settings slots or write pending settings now");
+		MCommandRegister("paramapply_set", CModule_Icicle::ParamApplySet, "[reset|lazy] [icicles per frame]: Set how distribution changes reach the icicles");
+		MCommandRegister("webslice_set", CModule_Icicle::WebSliceSet, "[bytes] [us]: Send pages in slices of at most this many bytes sized to take about this long to write and run frames that come due in between, 0 bytes sends in one piece");
+		MCommandRegister("homepage_bench", CModule_Icicle::HomePageBench, "[requests]: Time building the home page with and without the cache");
+		MCommandRegister("settings_set", CModule_Icicle::SettingsSet, "[key=value] ... or [blob=hex]: Set any number of settings at once with one save, nothing is set if any value is bad");
+		MCommandRegister("settings_get", CModule_Icicle::SettingsGet, "[blob]: Show all settings as key=value pairs or as a blob for settings_set");
+		MCommandRegister("stream_set", CModule_Icicle::StreamSet, "[first universe] [timeout ms]: Set the Art-Net universes of the stream and how long it lasts after the last packet");
+		MCommandRegister("stream_stats", CModule_Icicle::StreamStats, "[reset]: Show the stream frame rate and latency");
+		MCommandRegister("stream_bench", CModule_Icicle::StreamBench, "[frames]: Time decoding and presenting generated Art-Net frames");
+		MCommandRegister("show_record", CModule_Icicle::ShowRecord, "[frames] [keyframe interval] or [stop]: Record the output of the render mode for the playback mode");
+		MCommandRegister("show_seek", CModule_Icicle::ShowSeek, "[frame]: Move the playback mode to a frame of the show");
+		MCommandRegister("show_stats", CModule_Icicle::ShowStats, ": Show the size of the recorded show and where playback is");
+		MCommandRegister("sim_verify", CModule_Icicle::SimVerify, "[frames] [max us per frame]: Run dynamic ice from a fixed seed and check the frames against the golden hashes and the time budget");
+		MCommandRegister("show_bench", CModule_Icicle::ShowBench, "[frames] [keyframe interval]: Record dynamic ice and time recording and playing it back, this replaces the recorded show");
+		MCommandRegister("can_set", CModule_Icicle::CANSet, "[node] [nodes]: Set which shard of a roofline of controllers this one drives, node 0 paces the others when built with ICICLE_CAN");
+		MCommandRegister("can_stats", CModule_Icicle::CANStats, "[reset]: Show the frame syncs, settings broadcasts and bus utilization");
+		MCommandRegister("can_bench", CModule_Icicle::CANBench, "[followers] [frames] [seed]: Simulate followers with drifting clocks and show how closely they present with node 0");
+		MCommandRegister("capacity_plan", CModule_Icicle::CapacityPlan, "[icicles] [LEDs per icicle] [fps] [frames]: Run the model over a site one controller at a time and plan how many controllers it needs, not while dynamic ice, a show or a stream is on the LEDs");
+
+#if ICICLE_PERF_STATS && defined(__arm__)
+		// Start the cycle counter the perf stats are timed with
+		ARM_DEMCR |= ARM_DEMCR_TRCENA;
+		ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+
+		gCANBusBackend.Start();
+
+		leds.begin();
+		leds.show();
+	}
+
+	// Every settings change goes through here so anything built from the settings can be invalidated
+	void
+	SettingsSave(
+		void)
+	{
+		// The save is written behind by SettingsStore_Update() once the settings stop changing
+		++settingsSaveCount;
+		settingsDirty = true;
+		settingsChangedUS = micros();
+		settingsFlushing = false;
+		homePageValid = false;
+
+		// The other nodes get the settings once they stop changing, settings that came from another node aren't sent back
+		if(CAN_Active() && canSettingsFromBus == false)
+		{
+			canSettingsPending = true;
+			canSettingsChunk = 0;
+		}
+	}
+
+	uint16_t
+	SettingsStore_SlotAddress(
+		int	inSlot)
+	{
+		static_assert(eEEPROMSize >= eSettingsSlotCount * sizeof(settingsFlushImage), "the settings slots don't fit in the EEPROM");
+		static_assert(eEEPROMSize <= 0x10000, "EEPROM addresses are 16 bits");
+
+		return uint16_t(eEEPROMSize - (eSettingsSlotCount - inSlot) * sizeof(settingsFlushImage));
+	}
+
+	// Load the newest slot with a good crc, a slot that was only partly written when the power went out fails its crc so
+	//	the slot written before it is used instead
+	void
+	SettingsStore_Load(
+		void)
+	{
+		bool		found = false;
+		uint32_t	newestSequence = 0;
+		uint8_t		image[sizeof(settingsFlushImage)];
+
+		for(int slot = 0; slot < eSettingsSlotCount; ++slot)
+		{
+			uint16_t	address = SettingsStore_SlotAddress(slot);
+
+			for(size_t i = 0; i < sizeof(image); ++i)
+			{
+				image[i] = gSettingsStoreBackend.Read(uint16_t(address + i));
+			}
+
+			SSettingsSlotHeader const*	header = (SSettingsSlotHeader const*)image;
+
+			if(header->version != eSettingsVersion || header->size != sizeof(settings) || header->crc != SettingsStore_ImageCRC(image))
+			{
+				continue;
+			}
+
+			if(found == false || int32_t(header->sequence - newestSequence) > 0)
+			{
+				found = true;
+				newestSequence = header->sequence;
+				settingsSlot = (uint8_t)slot;
+				memcpy(&settings, image + sizeof(SSettingsSlotHeader), sizeof(settings));
+			}
+		}
+
+		if(found)
+		{
+			settingsSequence = newestSequence;
+			settingsDirty = false;
+		}
+		else
+		{
+			EEPROMInitialize();
+			settingsSlot = eSettingsSlotCount - 1;
+			settingsSequence = 0;
+			SettingsSave();
+		}
+	}
+
+	uint16_t
+	SettingsStore_ImageCRC(
+		uint8_t const*	inImage)
+	{
+		uint16_t	crc = SettingsStore_CRC(inImage, sizeof(SSettingsSlotHeader) - sizeof(uint16_t), 0xFFFF);
+
+		return SettingsStore_CRC(inImage + sizeof(SSettingsSlotHeader), sizeof(settings), crc);
+	}
+
+	void
+	SettingsStore_Update(
+		void)
+	{
+		if(settingsDirty && settingsFlushing == false && micros() - settingsChangedUS >= eSettingsQuietUS)
+		{
+			SettingsStore_StartFlush();
+		}
+
+		if(settingsFlushing)
+		{
+			SettingsStore_FlushSome(eSettingsFlushBytesPerUpdate);
+		}
+	}
+
+	// Snapshot the settings into the next slot's image, the oldest slot is overwritten so the newest one stays good until
+	//	this one is complete
+	void
+	SettingsStore_StartFlush(
+		void)
+	{
+		SSettingsSlotHeader*	header = (SSettingsSlotHeader*)settingsFlushImage;
+
+		header->sequence = settingsSequence + 1;
+		header->version = eSettingsVersion;
+		header->size = sizeof(settings);
+		memcpy(settingsFlushImage + sizeof(SSettingsSlotHeader), &settings, sizeof(settings));
+		header->crc = SettingsStore_ImageCRC(settingsFlushImage);
+
+		settingsFlushSlot = uint8_t((settingsSlot + 1) % eSettingsSlotCount);
+		settingsFlushOffset = 0;
+		settingsFlushing = true;
+		settingsDirty = false;
+	}
+
+	// Write up to inMaxWrites bytes that differ from what is already in the slot, the settings go first and the header last
+	void
+	SettingsStore_FlushSome(
+		uint32_t	inMaxWrites)
+	{
+		uint16_t	address = SettingsStore_SlotAddress(settingsFlushSlot);
+
+		for(; settingsFlushOffset < sizeof(settingsFlushImage); ++settingsFlushOffset)
+		{
+			size_t	i = (settingsFlushOffset + sizeof(SSettingsSlotHeader)) % sizeof(settingsFlushImage);
+
+			if(gSettingsStoreBackend.Read(uint16_t(address + i)) == settingsFlushImage[i])
+			{
+				continue;
+			}
+
+			if(inMaxWrites == 0)
+			{
+				return;
+			}
+
+			gSettingsStoreBackend.Write(uint16_t(address + i), settingsFlushImage[i]);
+			++settingsBytesWritten;
+			--inMaxWrites;
+		}
+
+		settingsFlushing = false;
+		settingsSlot = settingsFlushSlot;
+		settingsSequence = ((SSettingsSlotHeader*)settingsFlushImage)->sequence;
+		++settingsFlushCount;
+	}
+
+	uint8_t
+	SettingsStore(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "flush") != 0, eCmd_Failed);
+
+			// Write out any pending change now instead of waiting for the quiet period
+			if(settingsDirty)
+			{
+				SettingsStore_StartFlush();
+			}
+			if(settingsFlushing)
+			{
+				SettingsStore_FlushSome(0xFFFFFFFF);
+			}
+
+			return eCmd_Succeeded;
+		}
+
+		inOutput->printf("slot=%d sequence=%lu dirty=%d flushing=%d\n", settingsSlot, settingsSequence, settingsDirty, settingsFlushing);
+		inOutput->printf("saves=%lu flushes=%lu bytes written=%lu\n", settingsSaveCount, settingsFlushCount, settingsBytesWritten);
+
+		return eCmd_Succeeded;
+	}
+
+	// Lazy apply leaves the icicles alone so each one picks the new distributions up the next time it samples them, and
+	//	optionally resamples paramReseedPerFrame icicles a frame until all of them have the new distributions
+	void
+	ParamApply(
+		uint8_t	inTables)
+	{
+		if(settings.paramApply == eParamApply_Reset)
+		{
+			DynamicState_Reset();
+			return;
+		}
+
+		if(settings.paramReseedPerFrame > 0 && inTables != 0)
+		{
+			reseedTables |= inTables;
+			reseedRemaining = eIcicleTotal;
+		}
+	}
+
+	void
+	ParamApply_Update(
+		void)
+	{
+		uint32_t	count = reseedRemaining < settings.paramReseedPerFrame ? reseedRemaining : settings.paramReseedPerFrame;
+
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			icicles.ReseedIcicle(reseedCursor, reseedTables, this);
+			if(++reseedCursor >= eIcicleTotal)
+			{
+				reseedCursor = 0;
+			}
+		}
+
+		reseedRemaining -= count;
+		if(reseedRemaining == 0)
+		{
+			reseedTables = 0;
+		}
+	}
+
+	void
+	DynamicState_Reset(
+		void)
+	{
+		icicles.Reset();
+		reseedTables = 0;
+		reseedRemaining = 0;
+
+		for(int i = 0; i < eIcicleTotal; ++i)
+		{
+			icicles.SetInitialState(i, this);
+		}
+
+		frameInvalid = true;
+	}
+
+	void
+	GaussianTables_Build(
+		uint8_t	inTables)
+	{
+		// The clamps are the ranges SetNewState() allows for each field
+		if(inTables & eGaussianTable_GrowRate)
+		{
+			growRateTable.Build(settings.meanGrowRateLEDsPerSec, settings.stdGrowRateLEDsPerSec, float(1 << 12), 1, 0x1000);
+		}
+
+		if(inTables & eGaussianTable_PeekDepth)
+		{
+			peekDepthTable.Build(settings.meanPeekDepth, settings.stdPeekDepth, float(1 << 12), 0x17FF, eLEDsPerIcicle << 12);
+		}
+
+		if(inTables & eGaussianTable_PeekDepthLifetime)
+		{
+			peekDepthLifetimeTable.Build(settings.meanPeekDepthLifetimeSec, settings.stdPeekDepthLifetimeSec, float(1 << 12), 0x1000, 0x7000);
+		}
+
+		if(inTables & eGaussianTable_DripStartTime)
+		{
+			dripStartTimeTable.Build(settings.meanIcicleStartDripTime, settings.stdIcicleStartDripTime, float(1 << 8), 0, 0x7FFFFFFF);
+		}
+	}
+
+	void
+	RandomSeed(
+		uint32_t	inSeed)
+	{
+		randomSeed = inSeed;
+
+		// xorshift can't leave the all zero state
+		randomState = inSeed != 0 ? inSeed : 0x9E3779B9;
+	}
+
+	uint32_t
+	RandomNext(
+		void)
+	{
+		uint32_t	x = randomState;
+
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+
+		randomState = x;
+
+		return x;
+	}
+
+	// Returns a value from inMin up to but not including inMax
+	uint32_t
+	RandomRange(
+		uint32_t	inMin,
+		uint32_t	inMax)
+	{
+		return inMin + uint32_t((uint64_t(RandomNext()) * (inMax - inMin)) >> 32);
+	}
+
+	void
+	LayoutBuild(
+		void)
+	{
+		uint16_t const*	skippedLED = gSkippedLEDs;
+
+		for(int i = 0; i < eStripCount; ++i)
+		{
+			bool	reverseStrip = (gLEDLayout.stripReverseMask & (1 << i)) != 0;
+			int		usedLEDs = 0;
+
+			for(int j = 0; j < eLEDsPerStrip; ++j)
+			{
+				uint16_t	ledIndex = uint16_t(i * eLEDsPerStrip + j);
+
+				if(*skippedLED == ledIndex)
+				{
+					// A skipped LED inside an icicle would split it in two
+					MAssert(usedLEDs % eLEDsPerIcicle == 0);
+					++skippedLED;
+					continue;
+				}
+
+				int	slot = usedLEDs / eLEDsPerIcicle;
+				int	depth = usedLEDs % eLEDsPerIcicle;
+				int	icicle = i * eIciclesPerStrip + (reverseStrip ? eIciclesPerStrip - slot - 1 : slot);
+
+				if(gLEDLayout.serpentine && (slot & 1) == 1)
+				{
+					// odd icicles have reverse ordering so their last LED is the top
+					if(depth == eLEDsPerIcicle - 1)
+					{
+						gIcicleLEDMap[icicle] = uint16_t(ledIndex | eIcicleLEDMap_Reversed);
+					}
+				}
+				else if(depth == 0)
+				{
+					gIcicleLEDMap[icicle] = ledIndex;
+				}
+
+				++usedLEDs;
+			}
+
+			MAssert(usedLEDs == eIciclesPerStrip * eLEDsPerIcicle);
+		}
+
+		MAssert(*skippedLED == 0xFFFF);
+	}
+
+	// Passes page output on in slices and gives frames that come due a chance to run between slices, so a slow client
+	//	holds up the icicles for one slice at most. Each slice is sized from how long the client took to take the one
+	//	before so it takes about settings.webSliceUS to write, and is never more than settings.webSliceBytes. The first
+	//	slice is eWebSliceStartBytes since nothing is known about the client yet
+	class CSlicedOutputDirector : public IOutputDirector
+	{
+	public:
+
+		CSlicedOutputDirector(
+			IOutputDirector*	inOutput,
+			CModule_Icicle*		inModule)
+		:
+			output(inOutput),
+			module(inModule),
+			sliceBytes(inModule->settings.webSliceUS != 0 && inModule->settings.webSliceBytes > eWebSliceStartBytes ? eWebSliceStartBytes : inModule->settings.webSliceBytes)
+		{
+		}
+
+		virtual void
+		write(
+			char const*	inMsg,
+			size_t		inBytes)
+		{
+			size_t	maxBytes = module->settings.webSliceBytes;
+			size_t	sliceUS = module->settings.webSliceUS;
+
+			if(maxBytes == 0)
+			{
+				output->write(inMsg, inBytes);
+				return;
+			}
+
+			while(inBytes > 0)
+			{
+				size_t		bytes = inBytes < sliceBytes ? inBytes : sliceBytes;
+				uint32_t	startUS = micros();
+
+				output->write(inMsg, bytes);
+				inMsg += bytes;
+				inBytes -= bytes;
+
+				uint32_t	writeUS = micros() - startUS;
+
+				if(sliceUS != 0)
+				{
+					size_t	nextBytes = writeUS > 0 ? bytes * sliceUS / writeUS : maxBytes;
+
+					sliceBytes = nextBytes < 1 ? 1 : nextBytes > maxBytes ? maxBytes : nextBytes;
+				}
+
+				module->WebSlice_Yield();
+			}
+		}
+
+		IOutputDirector*	output;
+		CModule_Icicle*		module;
+		size_t				sliceBytes;
+	};
+
+	void
+	CommandHomePageHandler(
+		IOutputDirector*	inOutput,
+		int					inParamCount,
+		char const**		inParamList)
+	{
+		// Send html via in Output to add to the command server home page served to clients
+		CSlicedOutputDirector	slicedOutput(inOutput, this);
+
+		inOutput = &slicedOutput;
+		HomePage_Send(inOutput);
+
+		// free memory moves with the heap and the stack so the memory table is never cached
+		HomePage_RenderMemory(inOutput);
+
+#if ICICLE_PERF_STATS
+		// add frame phase timings, these change every frame so they are never cached
+		inOutput->printf("<table border=\"1\">");
+		inOutput->printf("<tr><th>Phase</th><th>Count</th><th>Min us</th><th>Avg us</th><th>P99 us</th><th>Max us</th></tr>");
+		for(int i = 0; i < ePerfPhase_Count; ++i)
+		{
+			SPerfHistogram const&	histogram = perfStats[i];
+
+			if(histogram.count == 0)
+			{
+				continue;
+			}
+
+			inOutput->printf("<tr><td>%s</td><td>%lu</td><td>%1.1f</td><td>%1.1f</td><td>%1.1f</td><td>%1.1f</td></tr>", gPerfPhaseStr[i], histogram.count, PerfCyclesToUS(histogram.minCycles), PerfCyclesToUS(histogram.totalCycles) / float(histogram.count), PerfCyclesToUS(histogram.GetP99Cycles()), PerfCyclesToUS(histogram.maxCycles));
+		}
+		inOutput->printf("</table>");
+#endif
+	}
+
+	// Runs any frame that comes due while a slow client holds up the loop. Update() takes the time it covered back out of
+	//	its next delta. The page is still being sent from the settings it started with so only the frame runs here, the
+	//	settings store, the stream and the CAN bus wait for Update() and so do frames paced by the stream or by node 0
+	void
+	WebSlice_Yield(
+		void)
+	{
+		uint32_t	nowUS = micros();
+		uint32_t	elapsedUS = nowUS - lastUpdateUS;
+
+		if(streamActive || CAN_Pacing() || frameElapsedUS + elapsedUS < frameIntervalUS)
+		{
+			return;
+		}
+
+		lastUpdateUS = nowUS;
+		webYieldedUS += elapsedUS;
+		++webYieldCount;
+
+		frameElapsedUS += elapsedUS;
+		FrameRun();
+	}
+
+	void
+	HomePage_Send(
+		IOutputDirector*	inOutput)
+	{
+		// The settings part of the page only changes through SettingsSave() so it is built once and sent in one write
+		if(homePageValid == false)
+		{
+			CBufferOutputDirector	cache(gHomePageCache, sizeof(gHomePageCache));
+
+			HomePage_Render(&cache);
+			homePageLength = cache.length;
+			homePageValid = cache.totalBytes <= sizeof(gHomePageCache);
+		}
+
+		if(homePageValid)
+		{
+			inOutput->write(gHomePageCache, homePageLength);
+		}
+		else
+		{
+			HomePage_Render(inOutput);
+		}
+	}
+
+	// Break down where the static RAM goes so the cost of a larger geometry can be seen before it is built
+	void
+	HomePage_RenderMemory(
+		IOutputDirector*	inOutput)
+	{
+		uint32_t	icicleBytes = sizeof(icicles) + sizeof(dirtyIcicles);
+		uint32_t	frameBytes = eFrameBufferBytes;
+		uint32_t	settingsBytes = sizeof(settings) + sizeof(settingsFlushImage) + sizeof(canSettingsImage) + sizeof(canSettingsReceiveImage) + sizeof(canSettingsAssembly) + sizeof(gHomePageCache);
+		uint32_t	tableBytes = sizeof(icePalette8dot8) + sizeof(dripPalette8dot8) + sizeof(gammaLUT) + sizeof(outputLUT) + sizeof(growRateTable) * 4;
+		uint32_t	showBytes = sizeof(gShowStoreBackend) + sizeof(showChunk) + sizeof(showKeyframeOffset);
+
+		inOutput->printf("<table border=\"1\">");
+		inOutput->printf("<tr><th>Memory</th><th>Bytes</th></tr>");
+		inOutput->printf("<tr><td>Icicle State</td><td>%lu</td></tr>", icicleBytes);
+		inOutput->printf("<tr><td>Frame Buffers</td><td>%lu</td></tr>", frameBytes);
+		inOutput->printf("<tr><td>Settings</td><td>%lu</td></tr>", settingsBytes);
+		inOutput->printf("<tr><td>Palettes And Tables</td><td>%lu</td></tr>", tableBytes);
+		inOutput->printf("<tr><td>Show</td><td>%lu</td></tr>", showBytes);
+		inOutput->printf("<tr><td>Module Total</td><td>%lu</td></tr>", uint32_t(sizeof(CModule_Icicle)));
+
+		uint32_t	staticBytes = StaticBytes();
+
+		inOutput->printf("<tr><td>Static Total</td><td>%lu</td></tr>", staticBytes);
+#if ICICLE_BOARD_RAM_BYTES > 0
+		inOutput->printf("<tr><td>Board RAM</td><td>%lu</td></tr>", uint32_t(ICICLE_BOARD_RAM_BYTES));
+		inOutput->printf("<tr><td>Board Headroom</td><td>%ld</td></tr>", long(ICICLE_BOARD_RAM_BYTES) - long(staticBytes));
+#endif
+#if !defined(WIN32)
+		inOutput->printf("<tr><td>Free</td><td>%lu</td></tr>", uint32_t(GetFreeMemory()));
+#endif
+		inOutput->printf("</table>");
+	}
+
+	void
+	HomePage_Render(
+		IOutputDirector*	inOutput)
+	{
+		inOutput->printf("<table border=\"1\">");
+		inOutput->printf("<tr><th>Parameter</th><th>Value</th></tr>");
+
+		// add render mode
+		inOutput->printf("<tr><td>RenderMode</td><td>%s</td></tr>", gRenderModeStr[settings.renderMode]);
+
+		// add random seed
+		inOutput->printf("<tr><td>RandomSeed</td><td>%lu</td></tr>", randomSeed);
+
+		// add parameter apply
+		inOutput->printf("<tr><td>ParamApply</td><td>%s %d</td></tr>", gParamApplyStr[settings.paramApply], settings.paramReseedPerFrame);
+
+		// add frame pacing
+		inOutput->printf("<tr><td>FramePacing</td><td>%s %lu us %d%%</td></tr>", gFramePacingStr[settings.framePacing], settings.frameIntervalUS, settings.frameBudgetPercent);
+
+		// add stream
+		inOutput->printf("<tr><td>Stream</td><td>universes %lu-%lu timeout %d ms</td></tr>", Stream_FirstUniverse(), Stream_FirstUniverse() + eStreamUniverseCount - 1, settings.streamTimeoutMS);
+
+		// add shard
+		inOutput->printf("<tr><td>Shard</td><td>node %d of %d icicles %lu-%lu</td></tr>", settings.canNodeIndex, settings.canNodeCount, uint32_t(settings.canNodeIndex) * eIcicleTotal, uint32_t(settings.canNodeIndex + 1) * eIcicleTotal - 1);
+
+		// add grow rate
+		inOutput->printf("<tr><td>GrowRate</td><td>%2.2f %2.2f</td></tr>", settings.meanGrowRateLEDsPerSec, settings.stdGrowRateLEDsPerSec);
+
+		// add peek depth
+		inOutput->printf("<tr><td>PeekDepth</td><td>%2.2f %2.2f</td></tr>", settings.meanPeekDepth, settings.stdPeekDepth);
+
+		// add peek depth lifetime
+		inOutput->printf("<tr><td>PeekDepthLifetime</td><td>%2.2f %2.2f</td></tr>", settings.meanPeekDepthLifetimeSec, settings.stdPeekDepthLifetimeSec);
+
+		// add drip time
+		inOutput->printf("<tr><td>DripTime</td><td>%2.2f %2.2f</td></tr>", settings.meanIcicleStartDripTime, settings.stdIcicleStartDripTime);
+
+		// add drip rate PreIcicleEnd
+		inOutput->printf("<tr><td>DripRate PreIcicleEnd</td><td>%2.2f</td></tr>", settings.waterDripRatePreLEDsPerSec);
+
+		// add drip rate PostIcicleEnd
+		inOutput->printf("<tr><td>DripRate PostIcicleEnd</td><td>%2.2f</td></tr>", settings.waterDripRatePostLEDsPerTick);
+
+		// add grow down color
+		inOutput->printf("<tr><td>GrowDown Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.growDownColorR / 255.0f, (float)settings.growDownColorG / 255.0f, (float)settings.growDownColorB / 255.0f);
+
+		// add recede up color
+		inOutput->printf("<tr><td>RecedeUp Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.recedeUpColorR / 255.0f, (float)settings.recedeUpColorG / 255.0f, (float)settings.recedeUpColorB / 255.0f);
+
+		// add water drip color
+		inOutput->printf("<tr><td>WaterDrip Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.waterDripR / 255.0f, (float)settings.waterDripG / 255.0f, (float)settings.waterDripB / 255.0f);
+
+		// add static color
+		inOutput->printf("<tr><td>Static Color</td><td>r:%1.3f g:%1.3f b:%1.3f</td></tr>", (float)settings.staticR / 255.0f, (float)settings.staticG / 255.0f, (float)settings.staticB / 255.0f);
+
+		// add static intensity
+		inOutput->printf("<tr><td>Static Intensity</td><td>%1.2f</td></tr>", settings.staticIntensity);
+
+		// add gamma
+		inOutput->printf("<tr><td>Gamma</td><td>r:%1.2f g:%1.2f b:%1.2f</td></tr>", settings.gammaR, settings.gammaG, settings.gammaB);
+
+		inOutput->printf("</table>");
+		
+		inOutput->printf("<table><tr><td><form action=\"rendermode\"><fieldset><legend>Change Render Mode</legend>");
+		for(int i = 0; i < eRenderMode_Count; ++i)
+		{
+			inOutput->printf("<input type=\"radio\" name=\"rendermode\" value=\"%s\" %s>%s<br>", gRenderModeStr[i], settings.renderMode == i ? "Checked" : "", gRenderModeStr[i]);
+		}
+		inOutput->printf("<input type=\"submit\" value=\"Submit\">");
+		inOutput->printf("</fieldset></form></td></tr></table>");
+	}
+
+	void
+	CommandRenderModePageHandler(
+		IOutputDirector*	inOutput,
+		int					inParamCount,
+		char const**		inParamList)
+	{
+		if(inParamCount != 2 || strcmp(inParamList[0], "rendermode") != 0)
+		{
+			return;
+		}
+		int i;
+		for(i = 0; i < eRenderMode_Count; ++i)
+		{
+			if (strcmp(inParamList[1], gRenderModeStr[i]) == 0)
+			{
+				settings.renderMode = (uint8_t)i;
+				SettingsSave();
+				break;
+			}
+		}
+	}
+
+	// Set every name/value pair of the request the same way settings_set does, then send all of the settings back so
+	//	they can be copied to another controller in the same request
+	void
+	CommandSettingsPageHandler(
+		IOutputDirector*	inOutput,
+		int					inParamCount,
+		char const**		inParamList)
+	{
+		CSlicedOutputDirector	slicedOutput(inOutput, this);
+
+		inOutput = &slicedOutput;
+
+		if(inParamCount >= 2)
+		{
+			SSettings	newSettings = settings;
+
+			for(int i = 0; i + 1 < inParamCount; i += 2)
+			{
+				if(SettingsField_Parse(&newSettings, inParamList[i], strlen(inParamList[i]), inParamList[i + 1]) == false)
+				{
+					inOutput->printf("bad setting %s=%s\n", inParamList[i], inParamList[i + 1]);
+					return;
+				}
+			}
+
+			SSettingsField const*	badField = SettingsValidate(newSettings);
+
+			if(badField != NULL)
+			{
+				inOutput->printf("bad setting %s\n", badField->key);
+				return;
+			}
+
+			SettingsApply(newSettings);
+		}
+
+		SettingsDump(inOutput);
+		SettingsDumpBlob(inOutput);
+	}
+
+	virtual void
+	LEDStateChange(
+		bool	inLEDsOn)
+	{
+		ledsOn = inLEDsOn;
+	}
+
+	virtual void
+	MotionSensorStateChange(
+		bool	inMotionSensorTriggered)
+	{
+
+	}
+
+	virtual void
+	PushButtonStateChange(
+		int	inToggleCount)
+	{
+
+	}
+
+	virtual void
+	TimeOfDayChange(
+		int	inTimeOfDay)
+	{
+
+	}
+
+	uint8_t
+	GrowDistributionSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
 
 		settings.meanGrowRateLEDsPerSec = (float)atof(inArgV[1]);
 		settings.stdGrowRateLEDsPerSec = (float)atof(inArgV[2]);
 
-		EEPROMSave();
+		SettingsSave();
+
+		GaussianTables_Build(eGaussianTable_GrowRate);
+
+		ParamApply(eGaussianTable_GrowRate);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	PeekDepthDistributionSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
+
+		settings.meanPeekDepth = (float)atof(inArgV[1]);
+		settings.stdPeekDepth = (float)atof(inArgV[2]);
+
+		SettingsSave();
+
+		GaussianTables_Build(eGaussianTable_PeekDepth);
+
+		ParamApply(eGaussianTable_PeekDepth);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t 
+	PeekDepthLifeDistributionSet(
+		IOutputDirector* inOutput,
+		int inArgC,
+		char const* inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
+
+		settings.meanPeekDepthLifetimeSec = (float)atof(inArgV[1]);
+		settings.stdPeekDepthLifetimeSec = (float)atof(inArgV[2]);
+
+		SettingsSave();
+
+		GaussianTables_Build(eGaussianTable_PeekDepthLifetime);
+
+		ParamApply(eGaussianTable_PeekDepthLifetime);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	DripStartTimeDistributionSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
+
+		settings.meanIcicleStartDripTime = (float)atof(inArgV[1]);
+		settings.stdIcicleStartDripTime = (float)atof(inArgV[2]);
+
+		SettingsSave();
+
+		GaussianTables_Build(eGaussianTable_DripStartTime);
+
+		ParamApply(eGaussianTable_DripStartTime);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	DripRateSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
+
+		settings.waterDripRatePreLEDsPerSec = (float)atof(inArgV[1]);
+		settings.waterDripRatePostLEDsPerTick = (float)atof(inArgV[2]);
+
+		SettingsSave();
+
+		// The drip rates are read on every update so there is nothing to pick up lazily
+		ParamApply(0);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	GrowDownColorSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 4, eCmd_Failed);
+		
+		settings.growDownColorR = (uint8_t)(atof(inArgV[1]) * 255.0);
+		settings.growDownColorG = (uint8_t)(atof(inArgV[2]) * 255.0);
+		settings.growDownColorB = (uint8_t)(atof(inArgV[3]) * 255.0);
+
+		SettingsSave();
+
+		DynamicPalette_Build();
+		frameInvalid = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	RecedeUpColorSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 4, eCmd_Failed);
+		
+		settings.recedeUpColorR = (uint8_t)(atof(inArgV[1]) * 255.0);
+		settings.recedeUpColorG = (uint8_t)(atof(inArgV[2]) * 255.0);
+		settings.recedeUpColorB = (uint8_t)(atof(inArgV[3]) * 255.0);
+
+		SettingsSave();
+
+		DynamicPalette_Build();
+		frameInvalid = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	StaticColorSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 4, eCmd_Failed);
+		
+		settings.staticR = (uint8_t)(atof(inArgV[1]) * 255.0);
+		settings.staticG = (uint8_t)(atof(inArgV[2]) * 255.0);
+		settings.staticB = (uint8_t)(atof(inArgV[3]) * 255.0);
+
+		SettingsSave();
+
+		frameInvalid = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	StaticIntensitySet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 2, eCmd_Failed);
+		
+		settings.staticIntensity = (float)atof(inArgV[1]);
+
+		SettingsSave();
+
+		OutputLUT_Build();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	GammaSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 2 && inArgC != 4, eCmd_Failed);
+
+		float	gammaR = (float)atof(inArgV[1]);
+		float	gammaG = inArgC == 4 ? (float)atof(inArgV[2]) : gammaR;
+		float	gammaB = inArgC == 4 ? (float)atof(inArgV[3]) : gammaR;
+
+		MReturnOnError(gammaR <= 0.0f || gammaG <= 0.0f || gammaB <= 0.0f, eCmd_Failed);
+
+		settings.gammaR = gammaR;
+		settings.gammaG = gammaG;
+		settings.gammaB = gammaB;
+
+		SettingsSave();
+
+		GammaLUT_Build();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	RandomSeedSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 2, eCmd_Failed);
+
+		RandomSeed((uint32_t)strtoul(inArgV[1], NULL, 0));
+		homePageValid = false;
+
+		DynamicState_Reset();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	RenderModeSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 2, eCmd_Failed);
+
+		int i;
+		for(i = 0; i < eRenderMode_Count; ++i)
+		{
+			if (strcmp(inArgV[1], gRenderModeStr[i]) == 0)
+			{
+				settings.renderMode = (uint8_t)i;
+				break;
+			}
+		}
+
+		if(i >= eRenderMode_Count)
+		{
+			return eCmd_Failed;
+		}
+
+		SettingsSave();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	RenderBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		int	frames = inArgC == 2 ? atoi(inArgV[1]) : 100;
+
+		MReturnOnError(frames <= 0, eCmd_Failed);
+
+		// The update and render timings exclude leds.show() so each mode is measured on its own, show is timed separately
+		//	below. The tick is everything UpdateFrame() does once the mode is up, including the show
+		uint8_t	savedRenderMode = settings.renderMode;
+		bool	savedLEDsOn = ledsOn;
+
+		inOutput->printf("%-12s %10s %10s %10s %12s\n", "mode", "update us", "render us", "tick us", "pixels/s");
+		for(int i = 0; i < eRenderMode_Count; ++i)
+		{
+			uint32_t	updateUS = 0;
+			uint32_t	renderUS = 0;
+			uint32_t	tickUS = 0;
+
+			// show_bench times playback
+			if(i == eRenderMode_Playback)
+			{
+				continue;
+			}
+
+			for(int j = 0; j < frames; ++j)
+			{
+				uint32_t	startUS = micros();
+
+				if(i == eRenderMode_DynamicIce)
+				{
+					UpdateModel(eFrameIntervalDefaultUS);
+				}
+
+				uint32_t	midUS = micros();
+
+				Render((uint8_t)i);
+
+				uint32_t	endUS = micros();
+
+				updateUS += midUS - startUS;
+				renderUS += endUS - midUS;
+			}
+
+			// The first tick of a mode draws the whole frame so it isn't timed
+			settings.renderMode = uint8_t(i);
+			ledsOn = true;
+			UpdateFrame(eFrameIntervalDefaultUS);
+			for(int j = 0; j < frames; ++j)
+			{
+				uint32_t	startUS = micros();
+
+				UpdateFrame(eFrameIntervalDefaultUS);
+				tickUS += micros() - startUS;
+			}
+
+			float	frameUS = float(updateUS + renderUS) / float(frames);
+
+			inOutput->printf("%-12s %10.1f %10.1f %10.1f %12.0f\n", gRenderModeStr[i], float(updateUS) / float(frames), float(renderUS) / float(frames), float(tickUS) / float(frames), frameUS > 0.0f ? float(eLEDsPerStrip * eStripCount) * 1000000.0f / frameUS : 0.0f);
+		}
+
+		settings.renderMode = savedRenderMode;
+		ledsOn = savedLEDsOn;
+
+		// Compare the batch transpose with writing the same frame one pixel at a time through OctoWS2811::setPixel()
+		uint32_t	startUS = micros();
+		for(int j = 0; j < frames; ++j)
+		{
+			FrameTranspose();
+		}
+		inOutput->printf("%-12s %10s %10.1f\n", "transpose", "", float(micros() - startUS) / float(frames));
+
+		startUS = micros();
+		for(int j = 0; j < frames; ++j)
+		{
+			uint8_t const*	rgb = gIcicleLEDFrame[0];
+
+			for(int k = 0; k < eLEDsPerStrip * eStripCount; ++k, rgb += 3)
+			{
+				leds.setPixel(k, rgb[0], rgb[1], rgb[2]);
+			}
+		}
+		inOutput->printf("%-12s %10s %10.1f\n", "setPixel", "", float(micros() - startUS) / float(frames));
+
+		// leds.show() blocks until the previous DMA transfer is done so this includes the wire time of a full frame
+		startUS = micros();
+		for(int j = 0; j < frames; ++j)
+		{
+			leds.show();
+		}
+		inOutput->printf("%-12s %10s %10.1f\n", "show", "", float(micros() - startUS) / float(frames));
+
+		// The frame buffer now holds whatever mode was timed last so redraw all of it
+		frameInvalid = true;
+		frameReady = false;
+		showRecordKeyNext = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	GeometryBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		int	frames = inArgC == 2 ? atoi(inArgV[1]) : 100;
+
+		MReturnOnError(frames <= 0, eCmd_Failed);
+
+		inOutput->printf("%-12s %10s %12s %8s\n", "geometry", "render us", "transpose us", "ns/LED");
+
+		// Geometries are strips x icicles per strip x LEDs per icicle. This installation, 3 LED drips and 10 LED icicles on
+		//	the same strips, and half as many strips
+		GeometryBench_Run<SInstallGeometry>(inOutput, frames);
+		GeometryBench_Run<SIcicleGeometry<eStripCount, eIciclesPerStrip * eLEDsPerIcicle / 3, 3> >(inOutput, frames);
+		GeometryBench_Run<SIcicleGeometry<eStripCount, eIciclesPerStrip * eLEDsPerIcicle / 10, 10> >(inOutput, frames);
+		GeometryBench_Run<SIcicleGeometry<(eStripCount + 1) / 2, eIciclesPerStrip, eLEDsPerIcicle> >(inOutput, frames);
+
+		// The benches drew over the frame
+		frameInvalid = true;
+		frameReady = false;
+		showRecordKeyNext = true;
+
+		return eCmd_Succeeded;
+	}
+
+	// Draw every icicle of tGeometry with its depth and drip moving along each frame and transpose the result. The frame
+	//	rows of the module are borrowed for it
+	template<typename tGeometry>
+	void
+	GeometryBench_Run(
+		IOutputDirector*	inOutput,
+		int					inFrames)
+	{
+		static_assert(int(tGeometry::eStripCount) <= int(eStripCount) && int(tGeometry::eLEDsPerStrip) <= int(eLEDsPerStrip), "a bench geometry has to fit in gIcicleLEDFrame");
+
+		uint8_t	(*frame)[tGeometry::eLEDsPerStrip * 3] = (uint8_t (*)[tGeometry::eLEDsPerStrip * 3])gIcicleLEDFrame[0];
+
+		memset(gIcicleLEDFrame, 0, sizeof(gIcicleLEDFrame));
+
+		SIcicleDraw	draw;
+		uint32_t	renderUS = 0;
+		uint32_t	transposeUS = 0;
+
+		draw.dripAFrac8 = 0x40;
+		draw.dripBFrac8 = 0xC0;
+		draw.iceColor8dot8 = icePalette8dot8[0x80];
+		draw.dripColorA8dot8 = dripPalette8dot8[draw.dripAFrac8];
+		draw.dripColorB8dot8 = dripPalette8dot8[draw.dripBFrac8];
+
+		for(int f = 0; f < inFrames; ++f)
+		{
+			uint32_t	startUS = micros();
+
+			for(int i = 0; i < tGeometry::eIcicleTotal; ++i)
+			{
+				uint32_t	depth8 = uint32_t(i * 37 + f * 16) % (tGeometry::eLEDsPerIcicle << 8);
+
+				draw.depthMag = depth8 >> 8;
+				draw.depthFrac8 = depth8 & 0xFF;
+				draw.dripAMag = uint32_t(i + f) % tGeometry::eLEDsPerIcicle;
+				draw.dripBMag = draw.dripAMag + 1;
+				// Every icicle straight down in strip order
+				uint16_t	mapEntry = uint16_t((i / tGeometry::eIciclesPerStrip) * tGeometry::eLEDsPerStrip + (i % tGeometry::eIciclesPerStrip) * tGeometry::eLEDsPerIcicle);
+
+				SIcicleKernels<tGeometry>::RenderIcicle(draw, mapEntry, frame[0]);
+			}
+
+			uint32_t	midUS = micros();
+
+			if(outputLUTIdentity)
+			{
+				SIcicleKernels<tGeometry>::template Transpose<false>(frame, outputLUT, (uint32_t*)gIcicleLEDDrawMemory);
+			}
+			else
+			{
+				SIcicleKernels<tGeometry>::template Transpose<true>(frame, outputLUT, (uint32_t*)gIcicleLEDDrawMemory);
+			}
+
+			renderUS += midUS - startUS;
+			transposeUS += micros() - midUS;
+		}
+
+		inOutput->printf("%1dx%3dx%2d     %10.1f %12.1f %8.1f\n", tGeometry::eStripCount, tGeometry::eIciclesPerStrip, tGeometry::eLEDsPerIcicle, float(renderUS) / float(inFrames), float(transposeUS) / float(inFrames), float(renderUS + transposeUS) * 1000.0f / (float(inFrames) * float(tGeometry::eStripCount * tGeometry::eLEDsPerStrip)));
+	}
+
+	uint8_t
+	DirtyStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			dirtyIcicleCount = 0;
+			dirtyFrameCount = 0;
+			skippedShowCount = 0;
+
+			return eCmd_Succeeded;
+		}
+
+		float	dirtyRatio = dirtyFrameCount > 0 ? float(dirtyIcicleCount) / (float(dirtyFrameCount) * float(eIcicleTotal)) : 0.0f;
+
+		inOutput->printf("frames=%lu dirty icicles=%lu ratio=%1.4f skipped shows=%lu\n", dirtyFrameCount, dirtyIcicleCount, dirtyRatio, skippedShowCount);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	DMAStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			framesSentCount = 0;
+			dmaWaitCount = 0;
+			dmaWaitTotalUS = 0;
+			dmaWaitMaxUS = 0;
+
+			return eCmd_Succeeded;
+		}
+
+		inOutput->printf("frames sent=%lu waited=%lu avg wait us=%1.1f max wait us=%lu\n", framesSentCount, dmaWaitCount, dmaWaitCount > 0 ? float(dmaWaitTotalUS) / float(dmaWaitCount) : 0.0f, dmaWaitMaxUS);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	FramePacingSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC < 2 || inArgC > 4, eCmd_Failed);
+
+		int	pacing;
+		for(pacing = 0; pacing < eFramePacing_Count; ++pacing)
+		{
+			if(strcmp(inArgV[1], gFramePacingStr[pacing]) == 0)
+			{
+				break;
+			}
+		}
+
+		MReturnOnError(pacing >= eFramePacing_Count, eCmd_Failed);
+
+		uint32_t	intervalUS = inArgC >= 3 ? (uint32_t)strtoul(inArgV[2], NULL, 0) : settings.frameIntervalUS;
+		int			budgetPercent = inArgC >= 4 ? atoi(inArgV[3]) : settings.frameBudgetPercent;
+
+		MReturnOnError(intervalUS < eFrameIntervalMinUS || intervalUS > eFrameIntervalMaxUS, eCmd_Failed);
+		MReturnOnError(budgetPercent < 1 || budgetPercent > 100, eCmd_Failed);
+
+		settings.framePacing = (uint8_t)pacing;
+		settings.frameIntervalUS = intervalUS;
+		settings.frameBudgetPercent = (uint8_t)budgetPercent;
+
+		SettingsSave();
+
+		FramePacing_Apply();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	FramePacingStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			FramePacing_ResetStats();
+
+			return eCmd_Succeeded;
+		}
+
+		uint32_t	elapsedUS = micros() - pacingStatsStartUS;
+
+		inOutput->printf("pacing=%s interval us=%lu budget=%d%% fps=%1.1f\n", gFramePacingStr[settings.framePacing], frameIntervalUS, settings.frameBudgetPercent, elapsedUS > 0 ? float(framesRunCount) * 1000000.0f / float(elapsedUS) : 0.0f);
+		inOutput->printf("frames=%lu missed deadlines=%lu coalesced frames=%lu avg cost us=%lu max cost us=%lu max interval us=%lu\n", framesRunCount, missedDeadlineCount, coalescedFrameCount, frameCostAvgUS, frameCostMaxUS, frameIntervalMaxUS);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	PerfStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+#if ICICLE_PERF_STATS
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			PerfStats_Reset();
+
+			return eCmd_Succeeded;
+		}
+
+		inOutput->printf("%-12s %8s %10s %10s %10s %10s\n", "phase", "count", "min us", "avg us", "p99 us", "max us");
+		for(int i = 0; i < ePerfPhase_Count; ++i)
+		{
+			SPerfHistogram const&	histogram = perfStats[i];
+
+			if(histogram.count == 0)
+			{
+				continue;
+			}
+
+			inOutput->printf("%-12s %8lu %10.1f %10.1f %10.1f %10.1f\n", gPerfPhaseStr[i], histogram.count, PerfCyclesToUS(histogram.minCycles), PerfCyclesToUS(histogram.totalCycles) / float(histogram.count), PerfCyclesToUS(histogram.GetP99Cycles()), PerfCyclesToUS(histogram.maxCycles));
+		}
+
+		return eCmd_Succeeded;
+#else
+		inOutput->printf("perf stats are compiled out, build with ICICLE_PERF_STATS 1\n");
+
+		return eCmd_Failed;
+#endif
+	}
+
+	uint8_t
+	ParamApplySet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC < 2 || inArgC > 3, eCmd_Failed);
+
+		int	paramApply;
+		for(paramApply = 0; paramApply < eParamApply_Count; ++paramApply)
+		{
+			if(strcmp(inArgV[1], gParamApplyStr[paramApply]) == 0)
+			{
+				break;
+			}
+		}
+
+		MReturnOnError(paramApply >= eParamApply_Count, eCmd_Failed);
+
+		int	reseedPerFrame = inArgC == 3 ? atoi(inArgV[2]) : settings.paramReseedPerFrame;
+
+		MReturnOnError(reseedPerFrame < 0 || reseedPerFrame > 0xFF, eCmd_Failed);
+
+		settings.paramApply = (uint8_t)paramApply;
+		settings.paramReseedPerFrame = (uint8_t)reseedPerFrame;
+
+		SettingsSave();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	WebSliceSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC < 2 || inArgC > 3, eCmd_Failed);
+
+		int	sliceBytes = atoi(inArgV[1]);
+		int	sliceUS = inArgC == 3 ? atoi(inArgV[2]) : settings.webSliceUS;
+
+		MReturnOnError(sliceBytes < 0 || sliceBytes > 0xFFFF, eCmd_Failed);
+		MReturnOnError(sliceUS < 0 || sliceUS > 0xFFFF, eCmd_Failed);
+
+		settings.webSliceBytes = (uint16_t)sliceBytes;
+		settings.webSliceUS = (uint16_t)sliceUS;
+
+		SettingsSave();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	HomePageBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		int	requests = inArgC == 2 ? atoi(inArgV[1]) : 20;
+
+		MReturnOnError(requests <= 0, eCmd_Failed);
+
+		// The output is only counted so this is the time the loop is held up building and handing off each page
+		inOutput->printf("%-8s %8s %8s %12s %10s\n", "page", "bytes", "writes", "us/request", "bytes/ms");
+		for(int i = 0; i < 2; ++i)
+		{
+			CBufferOutputDirector	counter(NULL, 0);
+			uint32_t				startUS = micros();
+
+			for(int j = 0; j < requests; ++j)
+			{
+				if(i == 0)
+				{
+					HomePage_Render(&counter);
+				}
+				else
+				{
+					HomePage_Send(&counter);
+				}
+			}
+
+			uint32_t	elapsedUS = micros() - startUS;
+
+			inOutput->printf("%-8s %8lu %8lu %12.1f %10.1f\n", i == 0 ? "uncached" : "cached", counter.totalBytes / requests, counter.writeCount / requests, float(elapsedUS) / float(requests), elapsedUS > 0 ? float(counter.totalBytes) * 1000.0f / float(elapsedUS) : 0.0f);
+		}
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	SettingsSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC < 2, eCmd_Failed);
+
+		// Everything is parsed into a copy and checked before any of it is applied
+		SSettings	newSettings = settings;
+
+		for(int i = 1; i < inArgC; ++i)
+		{
+			char const*	value = strchr(inArgV[i], '=');
+
+			if(value == NULL || SettingsField_Parse(&newSettings, inArgV[i], value - inArgV[i], value + 1) == false)
+			{
+				inOutput->printf("bad setting %s\n", inArgV[i]);
+				return eCmd_Failed;
+			}
+		}
+
+		SSettingsField const*	badField = SettingsValidate(newSettings);
+
+		if(badField != NULL)
+		{
+			inOutput->printf("bad setting %s\n", badField->key);
+			return eCmd_Failed;
+		}
+
+		SettingsApply(newSettings);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	SettingsGet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "blob") != 0, eCmd_Failed);
+
+			SettingsDumpBlob(inOutput);
+
+			return eCmd_Succeeded;
+		}
+
+		SettingsDump(inOutput);
+
+		return eCmd_Succeeded;
+	}
+
+	// Returns the settings field at inIndex or NULL past the last one
+	static SSettingsField const*
+	SettingsField_At(
+		int	inIndex)
+	{
+		// The distributions and drip rates only have to be finite, the ranges of the rest match their *_set commands
+		static SSettingsField const	fields[] =
+		{
+			{"growmean", eSettingsField_Float, offsetof(SSettings, meanGrowRateLEDsPerSec), -1.0e6f, 1.0e6f, NULL},
+			{"growstd", eSettingsField_Float, offsetof(SSettings, stdGrowRateLEDsPerSec), -1.0e6f, 1.0e6f, NULL},
+			{"depthmean", eSettingsField_Float, offsetof(SSettings, meanPeekDepth), -1.0e6f, 1.0e6f, NULL},
+			{"depthstd", eSettingsField_Float, offsetof(SSettings, stdPeekDepth), -1.0e6f, 1.0e6f, NULL},
+			{"peekdurationmean", eSettingsField_Float, offsetof(SSettings, meanPeekDepthLifetimeSec), -1.0e6f, 1.0e6f, NULL},
+			{"peekdurationstd", eSettingsField_Float, offsetof(SSettings, stdPeekDepthLifetimeSec), -1.0e6f, 1.0e6f, NULL},
+			{"driptimemean", eSettingsField_Float, offsetof(SSettings, meanIcicleStartDripTime), -1.0e6f, 1.0e6f, NULL},
+			{"driptimestd", eSettingsField_Float, offsetof(SSettings, stdIcicleStartDripTime), -1.0e6f, 1.0e6f, NULL},
+			{"dripratepre", eSettingsField_Float, offsetof(SSettings, waterDripRatePreLEDsPerSec), -1.0e6f, 1.0e6f, NULL},
+			{"dripratepost", eSettingsField_Float, offsetof(SSettings, waterDripRatePostLEDsPerTick), -1.0e6f, 1.0e6f, NULL},
+			{"staticintensity", eSettingsField_Float, offsetof(SSettings, staticIntensity), 0.0f, 1.0f, NULL},
+			{"gammar", eSettingsField_Float, offsetof(SSettings, gammaR), 0.01f, 10.0f, NULL},
+			{"gammag", eSettingsField_Float, offsetof(SSettings, gammaG), 0.01f, 10.0f, NULL},
+			{"gammab", eSettingsField_Float, offsetof(SSettings, gammaB), 0.01f, 10.0f, NULL},
+			{"growcolorr", eSettingsField_Color, offsetof(SSettings, growDownColorR), 0.0f, 1.0f, NULL},
+			{"growcolorg", eSettingsField_Color, offsetof(SSettings, growDownColorG), 0.0f, 1.0f, NULL},
+			{"growcolorb", eSettingsField_Color, offsetof(SSettings, growDownColorB), 0.0f, 1.0f, NULL},
+			{"recedecolorr", eSettingsField_Color, offsetof(SSettings, recedeUpColorR), 0.0f, 1.0f, NULL},
+			{"recedecolorg", eSettingsField_Color, offsetof(SSettings, recedeUpColorG), 0.0f, 1.0f, NULL},
+			{"recedecolorb", eSettingsField_Color, offsetof(SSettings, recedeUpColorB), 0.0f, 1.0f, NULL},
+			{"dripcolorr", eSettingsField_Color, offsetof(SSettings, waterDripR), 0.0f, 1.0f, NULL},
+			{"dripcolorg", eSettingsField_Color, offsetof(SSettings, waterDripG), 0.0f, 1.0f, NULL},
+			{"dripcolorb", eSettingsField_Color, offsetof(SSettings, waterDripB), 0.0f, 1.0f, NULL},
+			{"staticcolorr", eSettingsField_Color, offsetof(SSettings, staticR), 0.0f, 1.0f, NULL},
+			{"staticcolorg", eSettingsField_Color, offsetof(SSettings, staticG), 0.0f, 1.0f, NULL},
+			{"staticcolorb", eSettingsField_Color, offsetof(SSettings, staticB), 0.0f, 1.0f, NULL},
+			{"rendermode", eSettingsField_Enum, offsetof(SSettings, renderMode), 0.0f, float(eRenderMode_Count - 1), gRenderModeStr},
+			{"framepacing", eSettingsField_Enum, offsetof(SSettings, framePacing), 0.0f, float(eFramePacing_Count - 1), gFramePacingStr},
+			{"framebudget", eSettingsField_UInt8, offsetof(SSettings, frameBudgetPercent), 1.0f, 100.0f, NULL},
+			{"frameinterval", eSettingsField_UInt32, offsetof(SSettings, frameIntervalUS), float(eFrameIntervalMinUS), float(eFrameIntervalMaxUS), NULL},
+			{"webslice", eSettingsField_UInt16, offsetof(SSettings, webSliceBytes), 0.0f, float(0xFFFF), NULL},
+			{"webslicetime", eSettingsField_UInt16, offsetof(SSettings, webSliceUS), 0.0f, float(0xFFFF), NULL},
+			{"paramapply", eSettingsField_Enum, offsetof(SSettings, paramApply), 0.0f, float(eParamApply_Count - 1), gParamApplyStr},
+			{"reseedperframe", eSettingsField_UInt8, offsetof(SSettings, paramReseedPerFrame), 0.0f, float(0xFF), NULL},
+			{"streamuniverse", eSettingsField_UInt16, offsetof(SSettings, streamUniverse), 0.0f, float(0x8000 - eStreamUniverseCount), NULL},
+			{"streamtimeout", eSettingsField_UInt16, offsetof(SSettings, streamTimeoutMS), 100.0f, 60000.0f, NULL},
+			{"cannode", eSettingsField_UInt8, offsetof(SSettings, canNodeIndex), 0.0f, float(eCANNodeMax - 1), NULL, true},
+			{"cannodes", eSettingsField_UInt8, offsetof(SSettings, canNodeCount), 1.0f, float(eCANNodeMax), NULL, true},
+		};
+
+		return inIndex < int(sizeof(fields) / sizeof(fields[0])) ? &fields[inIndex] : NULL;
+	}
+
+	static float
+	SettingsField_Read(
+		SSettingsField const*	inField,
+		SSettings const&		inSettings)
+	{
+		uint8_t const*	value = (uint8_t const*)&inSettings + inField->offset;
+
+		switch(inField->type)
+		{
+			case eSettingsField_Float:
+				return *(float const*)value;
+
+			case eSettingsField_Color:
+				return float(*value) / 255.0f;
+
+			case eSettingsField_UInt16:
+				return float(*(uint16_t const*)value);
+
+			case eSettingsField_UInt32:
+				return float(*(uint32_t const*)value);
+
+			default:
+				return float(*value);
+		}
+	}
+
+	// Returns the settings field named by the inKeyLength characters of inKey or NULL if there isn't one
+	static SSettingsField const*
+	SettingsField_Find(
+		char const*	inKey,
+		size_t		inKeyLength)
+	{
+		SSettingsField const*	field;
+
+		for(int i = 0; (field = SettingsField_At(i)) != NULL; ++i)
+		{
+			if(strlen(field->key) == inKeyLength && strncmp(field->key, inKey, inKeyLength) == 0)
+			{
+				break;
+			}
+		}
+
+		return field;
+	}
+
+	// Parse inValue into the field named by the inKeyLength characters of inKey, or decode a whole blob from
+	//	settings_get blob. Returns false if the key is unknown or the value can't be parsed or is out of range
+	bool
+	SettingsField_Parse(
+		SSettings*	ioSettings,
+		char const*	inKey,
+		size_t		inKeyLength,
+		char const*	inValue)
+	{
+		if(inKeyLength == 4 && strncmp(inKey, "blob", 4) == 0)
+		{
+			return SettingsBlob_Decode(ioSettings, inValue);
+		}
+
+		SSettingsField const*	field = SettingsField_Find(inKey, inKeyLength);
+
+		if(field == NULL || *inValue == 0)
+		{
+			return false;
+		}
+
+		char*	end = NULL;
+		float	value;
+
+		if(field->type == eSettingsField_Enum)
+		{
+			for(value = 0.0f; value <= field->maxValue; value += 1.0f)
+			{
+				if(strcmp(inValue, field->names[int(value)]) == 0)
+				{
+					break;
+				}
+			}
+		}
+		else if(field->type == eSettingsField_Float || field->type == eSettingsField_Color)
+		{
+			value = (float)strtod(inValue, &end);
+		}
+		else
+		{
+			value = float(strtoul(inValue, &end, 0));
+		}
+
+		// This also catches a nan
+		if((end != NULL && *end != 0) || !(value >= field->minValue && value <= field->maxValue))
+		{
+			return false;
+		}
+
+		uint8_t*	fieldValue = (uint8_t*)ioSettings + field->offset;
+
+		switch(field->type)
+		{
+			case eSettingsField_Float:
+				*(float*)fieldValue = value;
+				break;
+
+			case eSettingsField_Color:
+				*fieldValue = uint8_t(value * 255.0f + 0.5f);
+				break;
+
+			case eSettingsField_UInt16:
+				*(uint16_t*)fieldValue = uint16_t(value);
+				break;
+
+			case eSettingsField_UInt32:
+				*(uint32_t*)fieldValue = uint32_t(value);
+				break;
+
+			default:
+				*fieldValue = uint8_t(value);
+				break;
+		}
+
+		return true;
+	}
+
+	// Returns the first field of inSettings that is out of range, or NULL if they all are good
+	SSettingsField const*
+	SettingsValidate(
+		SSettings const&	inSettings)
+	{
+		SSettingsField const*	field;
+
+		for(int i = 0; (field = SettingsField_At(i)) != NULL; ++i)
+		{
+			float	value = SettingsField_Read(field, inSettings);
+
+			if(!(value >= field->minValue && value <= field->maxValue))
+			{
+				return field;
+			}
+		}
+
+		// Each node streams from the universes after the ones of the nodes before it
+		if(inSettings.canNodeIndex >= inSettings.canNodeCount)
+		{
+			return SettingsField_Find("cannode", 7);
+		}
+
+		if(inSettings.streamUniverse + inSettings.canNodeCount * eStreamUniverseCount > 0x8000)
+		{
+			return SettingsField_Find("streamuniverse", 14);
+		}
+
+		return NULL;
+	}
+
+	// A blob is a settings slot image in hex, the header checks that it came from the same settings version and wasn't
+	//	cut short on the way
+	bool
+	SettingsBlob_Decode(
+		SSettings*	ioSettings,
+		char const*	inHex)
+	{
+		uint8_t	image[sizeof(settingsFlushImage)];
+
+		MReturnOnError(strlen(inHex) != sizeof(image) * 2, false);
+
+		for(size_t i = 0; i < sizeof(image) * 2; ++i)
+		{
+			char	c = inHex[i];
+			uint8_t	nibble;
+
+			if(c >= '0' && c <= '9')
+			{
+				nibble = uint8_t(c - '0');
+			}
+			else if(c >= 'a' && c <= 'f')
+			{
+				nibble = uint8_t(c - 'a' + 10);
+			}
+			else if(c >= 'A' && c <= 'F')
+			{
+				nibble = uint8_t(c - 'A' + 10);
+			}
+			else
+			{
+				return false;
+			}
+
+			image[i >> 1] = (i & 1) ? uint8_t(image[i >> 1] | nibble) : uint8_t(nibble << 4);
+		}
+
+		SSettings	newSettings;
+
+		MReturnOnError(SettingsImage_Read(image, &newSettings) == false, false);
+
+		// The node of the controller the blob came from is the local field it carries
+		newSettings.canNodeIndex = ioSettings->canNodeIndex;
+		newSettings.canNodeCount = ioSettings->canNodeCount;
+		*ioSettings = newSettings;
+
+		return true;
+	}
+
+	// A settings slot image of the current settings, for copying them to another controller
+	void
+	SettingsImage_Build(
+		uint8_t*	outImage)
+	{
+		SSettingsSlotHeader*	header = (SSettingsSlotHeader*)outImage;
+
+		memset(outImage, 0, sizeof(settingsFlushImage));
+		header->version = eSettingsVersion;
+		header->size = sizeof(SSettings);
+		memcpy(outImage + sizeof(SSettingsSlotHeader), &settings, sizeof(SSettings));
+		header->crc = SettingsStore_ImageCRC(outImage);
+	}
+
+	bool
+	SettingsImage_Read(
+		uint8_t const*	inImage,
+		SSettings*		outSettings)
+	{
+		SSettingsSlotHeader const*	header = (SSettingsSlotHeader const*)inImage;
+
+		MReturnOnError(header->version != eSettingsVersion || header->size != sizeof(SSettings) || header->crc != SettingsStore_ImageCRC(inImage), false);
+
+		memcpy(outSettings, inImage + sizeof(SSettingsSlotHeader), sizeof(SSettings));
+
+		return true;
+	}
+
+	// One line of key=value pairs that settings_set takes back as is, on this or any other controller
+	void
+	SettingsDump(
+		IOutputDirector*	inOutput)
+	{
+		SSettingsField const*	field;
+
+		for(int i = 0; (field = SettingsField_At(i)) != NULL; ++i)
+		{
+			if(field->local)
+			{
+				continue;
+			}
+
+			float	value = SettingsField_Read(field, settings);
+
+			switch(field->type)
+			{
+				case eSettingsField_Float:
+					inOutput->printf("%s=%.9g ", field->key, value);
+					break;
+
+				case eSettingsField_Color:
+					inOutput->printf("%s=%1.4f ", field->key, value);
+					break;
+
+				case eSettingsField_Enum:
+					inOutput->printf("%s=%s ", field->key, field->names[int(value)]);
+					break;
+
+				default:
+					inOutput->printf("%s=%lu ", field->key, (unsigned long)value);
+					break;
+			}
+		}
+
+		inOutput->printf("\n");
+	}
+
+	void
+	SettingsDumpBlob(
+		IOutputDirector*	inOutput)
+	{
+		static char const	hexDigits[] = "0123456789abcdef";
+		uint8_t				image[sizeof(settingsFlushImage)];
+		char				line[5 + sizeof(image) * 2 + 1];
+
+		SettingsImage_Build(image);
+
+		memcpy(line, "blob=", 5);
+		for(size_t i = 0; i < sizeof(image); ++i)
+		{
+			line[5 + i * 2] = hexDigits[image[i] >> 4];
+			line[5 + i * 2 + 1] = hexDigits[image[i] & 0xF];
+		}
+		line[sizeof(line) - 1] = '\n';
+
+		inOutput->write(line, sizeof(line));
+	}
+
+	// Apply a whole new set of settings with one save and at most one reset, only what the changed fields feed is rebuilt
+	void
+	SettingsApply(
+		SSettings const&	inSettings)
+	{
+		if(memcmp(&inSettings, &settings, sizeof(SSettings)) == 0)
+		{
+			return;
+		}
+
+		uint8_t	tables = 0;
+
+		if(inSettings.meanGrowRateLEDsPerSec != settings.meanGrowRateLEDsPerSec || inSettings.stdGrowRateLEDsPerSec != settings.stdGrowRateLEDsPerSec)
+		{
+			tables |= eGaussianTable_GrowRate;
+		}
+		if(inSettings.meanPeekDepth != settings.meanPeekDepth || inSettings.stdPeekDepth != settings.stdPeekDepth)
+		{
+			tables |= eGaussianTable_PeekDepth;
+		}
+		if(inSettings.meanPeekDepthLifetimeSec != settings.meanPeekDepthLifetimeSec || inSettings.stdPeekDepthLifetimeSec != settings.stdPeekDepthLifetimeSec)
+		{
+			tables |= eGaussianTable_PeekDepthLifetime;
+		}
+		if(inSettings.meanIcicleStartDripTime != settings.meanIcicleStartDripTime || inSettings.stdIcicleStartDripTime != settings.stdIcicleStartDripTime)
+		{
+			tables |= eGaussianTable_DripStartTime;
+		}
+
+		bool	dripRateChanged = inSettings.waterDripRatePreLEDsPerSec != settings.waterDripRatePreLEDsPerSec || inSettings.waterDripRatePostLEDsPerTick != settings.waterDripRatePostLEDsPerTick;
+		bool	gammaChanged = inSettings.gammaR != settings.gammaR || inSettings.gammaG != settings.gammaG || inSettings.gammaB != settings.gammaB;
+		bool	intensityChanged = inSettings.staticIntensity != settings.staticIntensity;
+		bool	staticColorChanged = inSettings.staticR != settings.staticR || inSettings.staticG != settings.staticG || inSettings.staticB != settings.staticB;
+
+		// The grow down, recede up and water drip colors are next to each other
+		bool	paletteChanged = memcmp(&inSettings.growDownColorR, &settings.growDownColorR, offsetof(SSettings, staticR) - offsetof(SSettings, growDownColorR)) != 0;
+		bool	nodeChanged = inSettings.canNodeIndex != settings.canNodeIndex || inSettings.canNodeCount != settings.canNodeCount;
+
+		settings = inSettings;
+
+		SettingsSave();
+
+		if(tables != 0)
+		{
+			GaussianTables_Build(tables);
+		}
+
+		if(paletteChanged)
+		{
+			DynamicPalette_Build();
+			frameInvalid = true;
+		}
+
+		if(staticColorChanged)
+		{
+			frameInvalid = true;
+		}
+
+		if(gammaChanged)
+		{
+			GammaLUT_Build();
+		}
+		else if(intensityChanged)
+		{
+			OutputLUT_Build();
+		}
+
+		FramePacing_Apply();
+
+		if(nodeChanged)
+		{
+			CAN_Reset();
+		}
+
+		if(tables != 0 || dripRateChanged)
+		{
+			ParamApply(tables);
+		}
+	}
+
+	uint8_t
+	StreamSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC < 2 || inArgC > 3, eCmd_Failed);
+
+		int	universe = atoi(inArgV[1]);
+		int	timeoutMS = inArgC == 3 ? atoi(inArgV[2]) : settings.streamTimeoutMS;
+
+		// Art-Net port addresses are 15 bits
+		MReturnOnError(universe < 0 || universe + settings.canNodeCount * eStreamUniverseCount > 0x8000, eCmd_Failed);
+		MReturnOnError(timeoutMS < 100 || timeoutMS > 60000, eCmd_Failed);
+
+		settings.streamUniverse = (uint16_t)universe;
+		settings.streamTimeoutMS = (uint16_t)timeoutMS;
+
+		SettingsSave();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	StreamStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			Stream_ResetStats();
+
+			return eCmd_Succeeded;
+		}
+
+		uint32_t	elapsedUS = micros() - streamStatsStartUS;
+		float		avgLatencyUS = streamFrameCount > 0 ? float(streamLatencyTotalUS) / float(streamFrameCount) : 0.0f;
+
+		inOutput->printf("active=%d fps=%1.1f frames=%lu packets=%lu bad packets=%lu overruns=%lu starts=%lu timeouts=%lu\n", streamActive, elapsedUS > 0 ? float(streamFrameCount) * 1000000.0f / float(elapsedUS) : 0.0f, streamFrameCount, streamPacketCount, streamBadPacketCount, streamOverrunCount, streamStartCount, streamTimeoutCount);
+
+		// The last LED of a strip lights up a whole strip of wire time after show
+		inOutput->printf("complete to show us avg=%1.1f max=%lu, to last LED add %d\n", avgLatencyUS, streamLatencyMaxUS, eFrameIntervalMinUS);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	StreamBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		int	frames = inArgC == 2 ? atoi(inArgV[1]) : 100;
+
+		MReturnOnError(frames <= 0, eCmd_Failed);
+
+		if(ledsOn == false)
+		{
+			inOutput->printf("the LEDs are off so the stream would be ignored\n");
+			return eCmd_Failed;
+		}
+
+		uint8_t		packet[eStreamHeaderSize + eStreamLEDsPerUniverse * 3];
+		uint32_t	receiveUS = 0;
+		uint32_t	presentUS = 0;
+
+		memcpy(packet, "Art-Net", 8);
+		packet[8] = eStreamOpCode_Dmx & 0xFF;
+		packet[9] = eStreamOpCode_Dmx >> 8;
+		packet[10] = 0;
+		packet[11] = 14;
+		packet[13] = 0;
+		packet[16] = (eStreamLEDsPerUniverse * 3) >> 8;
+		packet[17] = (eStreamLEDsPerUniverse * 3) & 0xFF;
+
+		Stream_ResetStats();
+
+		for(int i = 0; i < frames; ++i)
+		{
+			// A moving ramp so consecutive frames differ
+			for(int j = 0; j < eStreamLEDsPerUniverse * 3; ++j)
+			{
+				packet[eStreamHeaderSize + j] = uint8_t(i + j);
+			}
+
+			uint32_t	startUS = micros();
+
+			for(int j = 0; j < eStreamUniverseCount; ++j)
+			{
+				uint32_t	universe = Stream_FirstUniverse() + j;
+
+				packet[12] = uint8_t(i);
+				packet[14] = universe & 0xFF;
+				packet[15] = universe >> 8;
+				Stream_Receive(packet, sizeof(packet));
+			}
+
+			uint32_t	midUS = micros();
+
+			Stream_Update();
+
+			receiveUS += midUS - startUS;
+			presentUS += micros() - midUS;
+		}
+
+		float	frameUS = float(receiveUS + presentUS) / float(frames);
+
+		// Presenting includes waiting for the DMA of the previous frame so it is bound by the wire time
+		inOutput->printf("receive us=%1.1f present us=%1.1f fps=%1.1f MB/s=%1.2f\n", float(receiveUS) / float(frames), float(presentUS) / float(frames), frameUS > 0.0f ? 1000000.0f / frameUS : 0.0f, frameUS > 0.0f ? float(eStreamUniverseCount * sizeof(packet)) / frameUS : 0.0f);
+		inOutput->printf("complete to show us avg=%1.1f max=%lu\n", streamFrameCount > 0 ? float(streamLatencyTotalUS) / float(streamFrameCount) : 0.0f, streamLatencyMaxUS);
+
+		// Hand the LEDs back to the set render mode
+		streamLastPacketUS = micros() - uint32_t(settings.streamTimeoutMS) * 1000;
+		Stream_Update();
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	CANSet(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 3, eCmd_Failed);
+
+		int	node = atoi(inArgV[1]);
+		int	nodes = atoi(inArgV[2]);
+
+		MReturnOnError(nodes < 1 || nodes > eCANNodeMax || node < 0 || node >= nodes, eCmd_Failed);
+
+		SSettings	newSettings = settings;
+
+		newSettings.canNodeIndex = (uint8_t)node;
+		newSettings.canNodeCount = (uint8_t)nodes;
+
+		// The stream universes of the last node have to fit
+		MReturnOnError(SettingsValidate(newSettings) != NULL, eCmd_Failed);
+
+		SettingsApply(newSettings);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	CANStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 2, eCmd_Failed);
+
+		if(inArgC == 2)
+		{
+			MReturnOnError(strcmp(inArgV[1], "reset") != 0, eCmd_Failed);
+
+			CAN_ResetStats();
+
+			return eCmd_Succeeded;
+		}
+
+		uint32_t	elapsedUS = micros() - canStatsStartUS;
+		float		busPercent = elapsedUS > 0 ? float(canBitsSent + canBitsReceived) * (100.0f * 1000000.0f / float(eCANBitRate)) / float(elapsedUS) : 0.0f;
+
+		inOutput->printf("node %d of %d %s synced=%d\n", settings.canNodeIndex, settings.canNodeCount, settings.canNodeIndex == 0 ? "master" : "follower", canSynced);
+		inOutput->printf("syncs sent=%lu received=%lu missed=%lu late=%lu fallbacks=%lu\n", canSyncSentCount, canSyncReceivedCount, canSyncMissedCount, canLateCount, canFallbackCount);
+
+		// The delay spread bounds how far off the clock offset can be, the spin overshoot is added on top
+		inOutput->printf("jitter us delay spread=%lu present overshoot max=%lu\n", canClockSync.Spread(), canPresentErrorMaxUS);
+		inOutput->printf("settings sent=%lu applied=%lu bad frames=%lu write fails=%lu\n", canSettingsSentCount, canSettingsAppliedCount, canBadFrameCount, canWriteFailCount);
+		inOutput->printf("bus bits sent=%lu received=%lu utilization=%1.2f%%\n", canBitsSent, canBitsReceived, busPercent);
+
+		return eCmd_Succeeded;
+	}
+
+	// Run node 0 and a number of followers in simulated time through the sync code. Each follower has its own clock
+	//	offset and drift and picks up each sync a random part of a tick after it arrives, the error is when it presents
+	//	compared to node 0. A seed gives the same followers and the same numbers every run
+	uint8_t
+	CANBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 4, eCmd_Failed);
+
+		int			followers = inArgC >= 2 ? atoi(inArgV[1]) : 3;
+		int			frames = inArgC >= 3 ? atoi(inArgV[2]) : 1000;
+		uint32_t	seed = inArgC >= 4 ? (uint32_t)strtoul(inArgV[3], NULL, 0) : micros();
+
+		MReturnOnError(followers < 1 || followers >= eCANNodeMax || frames <= eCANClockWindow, eCmd_Failed);
+
+		SCANClockSync	clockSync[eCANNodeMax - 1];
+		uint32_t		offsetUS[eCANNodeMax - 1];
+		int32_t			driftPPM[eCANNodeMax - 1];
+
+		// xorshift never leaves a state of 0
+		seed |= 1;
+
+		for(int i = 0; i < followers; ++i)
+		{
+			clockSync[i].Reset();
+			offsetUS[i] = CANBench_Random(seed);
+			driftPPM[i] = int32_t(CANBench_Random(seed) % 101) - 50;
+		}
+
+		uint32_t	errorTotalUS = 0;
+		uint32_t	errorMaxUS = 0;
+		uint32_t	errorCount = 0;
+		uint32_t	lateCount = 0;
+		uint32_t	startUS = micros();
+
+		for(int i = 0; i < frames; ++i)
+		{
+			// Node 0 sends on a tick so the lead varies by up to a tick
+			uint64_t	presentUS = 1000000 + uint64_t(i) * frameIntervalUS;
+			uint32_t	leadUS = eCANSyncLeadUS - CANBench_Random(seed) % eUpdateTimeUS;
+			uint64_t	sendUS = presentUS - leadUS;
+
+			for(int j = 0; j < followers; ++j)
+			{
+				// The sync may wait for a frame already on the bus, then it is read on the next tick of the follower
+				uint64_t	arriveUS = sendUS + eCANFrameBits8 + CANBench_Random(seed) % eCANFrameBits8;
+				uint32_t	readUS = CANBench_Clock(offsetUS[j], driftPPM[j], arriveUS) + CANBench_Random(seed) % eUpdateTimeUS;
+				uint32_t	localPresentUS = uint32_t(presentUS) + clockSync[j].Add(readUS - uint32_t(sendUS));
+
+				if(int32_t(localPresentUS - readUS) < 0)
+				{
+					++lateCount;
+				}
+
+				// The first syncs only fill the window
+				if(i < eCANClockWindow)
+				{
+					continue;
+				}
+
+				int32_t		errorUS = int32_t(localPresentUS - CANBench_Clock(offsetUS[j], driftPPM[j], presentUS));
+				uint32_t	absErrorUS = errorUS < 0 ? uint32_t(-errorUS) : uint32_t(errorUS);
+
+				errorTotalUS += absErrorUS;
+				if(absErrorUS > errorMaxUS)
+				{
+					errorMaxUS = absErrorUS;
+				}
+				++errorCount;
+			}
+		}
+
+		uint32_t	syncUS = micros() - startUS;
+
+		// Push the settings through the chunks and back
+		uint8_t					image[sizeof(canSettingsImage)];
+		uint8_t					receiveImage[sizeof(canSettingsImage)];
+		SCANSettingsAssembly	assembly;
+		SSettings				received;
+		uint32_t				chunkCount = (sizeof(image) + eCANSettingsChunkBytes - 1) / eCANSettingsChunkBytes;
+		uint32_t				settingsBits = 0;
+		bool					complete = false;
+
+		SettingsImage_Build(image);
+		assembly.Reset();
+		for(uint32_t i = 0; i < chunkCount; ++i)
+		{
+			uint32_t	bytes = sizeof(image) - i * eCANSettingsChunkBytes < eCANSettingsChunkBytes ? sizeof(image) - i * eCANSettingsChunkBytes : eCANSettingsChunkBytes;
+			uint8_t		data[8];
+
+			data[0] = uint8_t(i);
+			memcpy(data + 1, image + i * eCANSettingsChunkBytes, bytes);
+			settingsBits += CAN_FrameBits(uint8_t(bytes + 1));
+			complete = assembly.Add(eCANId_Settings, uint8_t(bytes + 1), data, receiveImage, sizeof(receiveImage));
+		}
+
+		bool	settingsGood = complete && SettingsImage_Read(receiveImage, &received) && memcmp(&received, &settings, sizeof(SSettings)) == 0;
+
+		inOutput->printf("%d followers %d frames at %lu us, %1.2f us per sync\n", followers, frames, frameIntervalUS, float(syncUS) / float(frames * followers));
+		inOutput->printf("present jitter us avg=%1.1f max=%lu late=%lu\n", errorCount > 0 ? float(errorTotalUS) / float(errorCount) : 0.0f, errorMaxUS, lateCount);
+		inOutput->printf("bus sync utilization=%1.2f%% settings broadcast=%lu frames %lu us %s\n", float(eCANFrameBits8) * (100.0f * 1000000.0f / float(eCANBitRate)) / float(frameIntervalUS), chunkCount, settingsBits * (1000000 / eCANBitRate), settingsGood ? "ok" : "bad");
+
+		return settingsGood && lateCount == 0 ? eCmd_Succeeded : eCmd_Failed;
+	}
+
+	// The clock of a follower at inUS of the clock of node 0
+	static uint32_t
+	CANBench_Clock(
+		uint32_t	inOffsetUS,
+		int32_t		inDriftPPM,
+		uint64_t	inUS)
+	{
+		return inOffsetUS + uint32_t(inUS) + uint32_t(int64_t(inUS) * inDriftPPM / 1000000);
+	}
+
+	// xorshift32, kept apart from the RNG of the dynamic ice
+	static uint32_t
+	CANBench_Random(
+		uint32_t&	ioState)
+	{
+		ioState ^= ioState << 13;
+		ioState ^= ioState >> 17;
+		ioState ^= ioState << 5;
+
+		return ioState;
+	}
+
+	// Plan the controllers of a site. The cost of an icicle comes from running this build of the model and renderer over
+	//	the whole site, eIcicleTotal icicles at a time from a seed of their own the way each controller of a roofline
+	//	would, so it reflects the settings and CPU it runs on. The controllers only share the CAN sync so the site scales
+	//	with the controller count, the plan gives every controller an even share and sizes for the slowest shard. At most
+	//	eCapacityPlanShardMax shards are timed here, host/IciclePlan.cpp runs every shard of a site over every core of a
+	//	desktop
+	uint8_t
+	CapacityPlan(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 5, eCmd_Failed);
+
+		uint32_t	siteIcicles = inArgC >= 2 ? (uint32_t)strtoul(inArgV[1], NULL, 0) : eIcicleTotal * eCANNodeMax;
+		uint32_t	ledsPerIcicle = inArgC >= 3 ? (uint32_t)strtoul(inArgV[2], NULL, 0) : eLEDsPerIcicle;
+		uint32_t	fps = inArgC >= 4 ? (uint32_t)strtoul(inArgV[3], NULL, 0) : 1000000 / eFrameIntervalDefaultUS;
+		int			frames = inArgC >= 5 ? atoi(inArgV[4]) : 30;
+
+		MReturnOnError(CapacityPlan_Valid(siteIcicles, ledsPerIcicle, fps, frames) == false, eCmd_Failed);
+
+		// The shards run on the icicles and frame buffers of the show, only a mode that is drawn again from the settings
+		//	can give them up
+		uint8_t	renderMode = ledsOn ? settings.renderMode : (uint8_t)eRenderMode_AllOff;
+
+		if(renderMode == eRenderMode_DynamicIce || renderMode == eRenderMode_Playback || streamActive || showRecording)
+		{
+			inOutput->printf("can't plan while dynamic ice, a show or a stream is on the LEDs\n");
+			return eCmd_Failed;
+		}
+
+		SCapacityTiming	timing = {};
+		uint32_t		shards = (siteIcicles + eIcicleTotal - 1) / eIcicleTotal;
+
+		CapacityPlan_RunShards(randomSeed, 0, shards < eCapacityPlanShardMax ? shards : eCapacityPlanShardMax, 1000000 / fps, frames, timing);
+		CapacityPlan_Report(inOutput, siteIcicles, ledsPerIcicle, fps, frames, timing);
+
+		return eCmd_Succeeded;
+	}
+
+	static bool
+	CapacityPlan_Valid(
+		uint32_t	inSiteIcicles,
+		uint32_t	inLEDsPerIcicle,
+		uint32_t	inFPS,
+		int			inFrames)
+	{
+		if(inSiteIcicles == 0 || inSiteIcicles > eCapacityPlanIcicleMax || inLEDsPerIcicle == 0 || inLEDsPerIcicle > eCapacityPlanLEDsPerIcicleMax)
+		{
+			return false;
+		}
+
+		if(inFPS == 0 || inFPS > eCapacityPlanFPSMax || inFrames < 2 || inFrames > eCapacityPlanFrameMax)
+		{
+			return false;
+		}
+
+		// The strips have to clock out in a frame
+		return 1000000 / inFPS >= inLEDsPerIcicle * 30 + 300;
+	}
+
+	// Run inShardCount shards from inFirstShard of the site through the model, dynamic render and transpose the way
+	//	SimVerify() does but with the settings in use. The first frame draws every icicle so only the frames after it are
+	//	timed. This takes over the icicles and the frame, the mode on the LEDs is drawn again afterwards
+	void
+	CapacityPlan_RunShards(
+		uint32_t			inSeed,
+		uint32_t			inFirstShard,
+		uint32_t			inShardCount,
+		uint32_t			inIntervalUS,
+		int					inFrames,
+		SCapacityTiming&	ioTiming)
+	{
+		uint32_t	savedSeed = randomSeed;
+
+		renderedMode = eRenderMode_DynamicIce;
+		for(uint32_t i = inFirstShard; i < inFirstShard + inShardCount; ++i)
+		{
+			uint32_t	shardUS = 0;
+
+			RandomSeed(inSeed + i);
+			updateCumulatorUS = 0;
+			DynamicState_Reset();
+
+			for(int j = 0; j < inFrames; ++j)
+			{
+				uint32_t	startUS = micros();
+
+				UpdateModel(inIntervalUS);
+				ParamApply_Update();
+
+				uint32_t	midUS = micros();
+
+				if(j == 0)
+				{
+					RenderDynamicIce();
+				}
+				else
+				{
+					RenderDynamicIceDirty();
+				}
+
+				uint32_t	renderEndUS = micros();
+
+				FrameTranspose();
+
+				uint32_t	endUS = micros();
+
+				if(j == 0)
+				{
+					continue;
+				}
+
+				ioTiming.updateUS += midUS - startUS;
+				ioTiming.renderUS += renderEndUS - midUS;
+				ioTiming.transposeUS += endUS - renderEndUS;
+				shardUS += endUS - startUS;
+			}
+
+			if(shardUS > ioTiming.shardMaxUS)
+			{
+				ioTiming.shardMaxUS = shardUS;
+			}
+			++ioTiming.shards;
+		}
+
+		renderedMode = 0xFF;
+		RandomSeed(savedSeed);
+		updateCumulatorUS = 0;
+		DynamicState_Reset();
+		frameReady = false;
+		frameInvalid = true;
+		showRecordKeyNext = true;
+	}
+
+	void
+	CapacityPlan_Report(
+		IOutputDirector*		inOutput,
+		uint32_t				inSiteIcicles,
+		uint32_t				inLEDsPerIcicle,
+		uint32_t				inFPS,
+		int						inFrames,
+		SCapacityTiming const&	inTiming)
+	{
+		// Each OctoWS2811 controller clocks out 8 strips at 30us per LED plus the 300us latch
+		uint32_t const	stripsPerController = 8;
+		uint32_t		intervalUS = 1000000 / inFPS;
+		uint32_t		budgetUS = intervalUS * settings.frameBudgetPercent / 100;
+		uint32_t		shards = inTiming.shards;
+
+		// Cost per icicle at inLEDsPerIcicle, the model is per icicle and the render and transpose are per LED
+		float	timedFrames = float(shards) * float(inFrames - 1);
+		float	updateIcicleUS = float(inTiming.updateUS) / (timedFrames * float(eIcicleTotal));
+		float	renderLEDUS = float(inTiming.renderUS) / (timedFrames * float(eIcicleTotal * eLEDsPerIcicle));
+		float	transposeLEDUS = float(inTiming.transposeUS) / (timedFrames * float(eStripCount * eLEDsPerStrip));
+		float	icicleUS = updateIcicleUS + (renderLEDUS + transposeLEDUS) * float(inLEDsPerIcicle);
+		float	shardAvgUS = float(inTiming.updateUS + inTiming.renderUS + inTiming.transposeUS) / float(shards);
+		float	worstRatio = shardAvgUS > 0.0f ? float(inTiming.shardMaxUS) / shardAvgUS : 1.0f;
+
+		inOutput->printf("measured %lu shards x %d frames: update %1.1f ns/icicle render %1.1f ns/LED transpose %1.1f ns/LED, slowest shard x%1.2f\n", shards, inFrames - 1, updateIcicleUS * 1000.0f, renderLEDUS * 1000.0f, transposeLEDUS * 1000.0f, worstRatio);
+
+		// A controller is limited by the strips it can clock out in a frame and by the frame budget of its CPU
+		uint32_t	wireIcicles = ((intervalUS - 300) / 30 / inLEDsPerIcicle) * stripsPerController;
+		uint32_t	cpuIcicles = icicleUS > 0.0f ? uint32_t(float(budgetUS) / (icicleUS * worstRatio)) : wireIcicles;
+		uint32_t	controllerIcicles = wireIcicles < cpuIcicles ? wireIcicles : cpuIcicles;
+
+		inOutput->printf("site %lu icicles x %lu LEDs at %lu fps, %lu us frames with a %lu us budget\n", inSiteIcicles, inLEDsPerIcicle, inFPS, intervalUS, budgetUS);
+		inOutput->printf("controller limit wire=%lu cpu=%lu icicles\n", wireIcicles, cpuIcicles);
+
+		if(controllerIcicles == 0)
+		{
+			inOutput->printf("no controller can run an icicle at this rate\n");
+			return;
+		}
+
+		uint32_t	controllers = (inSiteIcicles + controllerIcicles - 1) / controllerIcicles;
+		uint32_t	shareIcicles = (inSiteIcicles + controllers - 1) / controllers;
+		uint32_t	ledsPerStrip = (shareIcicles + stripsPerController - 1) / stripsPerController * inLEDsPerIcicle;
+		uint32_t	wireUS = ledsPerStrip * 30 + 300;
+		float		cpuAvgUS = float(shareIcicles) * icicleUS;
+		float		cpuWorstUS = cpuAvgUS * worstRatio;
+		float		frameUS = cpuWorstUS > float(wireUS) ? cpuWorstUS : float(wireUS);
+		float		controllerBytesPerSec = float(shareIcicles * inLEDsPerIcicle * 3) * float(inFPS);
+		uint32_t	universes = (ledsPerStrip + eStreamLEDsPerUniverse - 1) / eStreamLEDsPerUniverse * stripsPerController;
+		uint32_t	buses = (controllers + eCANNodeMax - 1) / eCANNodeMax;
+
+		inOutput->printf("%lu controllers of %lu icicles, %lu LEDs per strip\n", controllers, shareIcicles, ledsPerStrip);
+		inOutput->printf("controller cpu avg=%1.0f us worst=%1.0f us %1.0f%% wire=%lu us %1.0f%% frame=%1.0f us\n", cpuAvgUS, cpuWorstUS, cpuWorstUS * 100.0f / float(intervalUS), wireUS, float(wireUS) * 100.0f / float(intervalUS), frameUS);
+		inOutput->printf("output %1.1f KB/s per controller %1.2f MB/s for the site, stream %lu universes per controller\n", controllerBytesPerSec / 1024.0f, controllerBytesPerSec * float(controllers) / (1024.0f * 1024.0f), universes);
+		inOutput->printf("can %lu buses of %d nodes, sync utilization=%1.2f%%\n", buses, eCANNodeMax, float(eCANFrameBits8) * float(inFPS) * 100.0f / float(eCANBitRate));
+	}
+
+	uint8_t
+	ShowRecord(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 3, eCmd_Failed);
+
+		if(inArgC == 2 && strcmp(inArgV[1], "stop") == 0)
+		{
+			MReturnOnError(showRecording == false, eCmd_Failed);
+
+			ShowRecord_Stop();
+			inOutput->printf("recorded %lu frames %lu bytes%s\n", showRecordFrame, showRecordBytes, showRecordFull ? ", the store filled up" : "");
+
+			return eCmd_Succeeded;
+		}
+
+		int	frames = inArgC >= 2 ? atoi(inArgV[1]) : 1000;
+		int	keyframeInterval = inArgC >= 3 ? atoi(inArgV[2]) : eShowKeyframeIntervalDefault;
+
+		MReturnOnError(frames <= 0 || keyframeInterval < 1 || keyframeInterval > 0xFF, eCmd_Failed);
+
+		if(showRecording)
+		{
+			ShowRecord_Stop();
+		}
+
+		if(ShowRecord_Start(frames, (uint8_t)keyframeInterval) == false)
+		{
+			inOutput->printf("can't record while playing back or without a show store\n");
+			return eCmd_Failed;
+		}
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	ShowSeek(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC != 2, eCmd_Failed);
+		MReturnOnError(ShowPlay_Open(0xFFFFFFFF) == false, eCmd_Failed);
+
+		// The frame before the one asked for is shown now and the playback goes on from there
+		uint32_t	frame = (uint32_t)strtoul(inArgV[1], NULL, 0);
+
+		showPlayFrame = frame % showFrameCount + 1;
+		frameInvalid = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	ShowStats(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		if(showRecording)
+		{
+			inOutput->printf("recording frame=%lu bytes=%lu\n", showRecordFrame, showRecordBytes);
+			return eCmd_Succeeded;
+		}
+
+		if(ShowPlay_Open(0xFFFFFFFF) == false)
+		{
+			inOutput->printf("no show recorded\n");
+			return eCmd_Succeeded;
+		}
+
+		inOutput->printf("frames=%lu keyframes=%d every %d frames, playing frame %lu\n", showFrameCount, showKeyframeCount, showKeyframeInterval, showPlayFrame);
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	ShowBench(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 3, eCmd_Failed);
+
+		int	frames = inArgC >= 2 ? atoi(inArgV[1]) : 300;
+		int	keyframeInterval = inArgC >= 3 ? atoi(inArgV[2]) : eShowKeyframeIntervalDefault;
+
+		MReturnOnError(frames <= 0 || keyframeInterval < 1 || keyframeInterval > 0xFF, eCmd_Failed);
+
+		if(showRecording)
+		{
+			ShowRecord_Stop();
+		}
+
+		MReturnOnError(ShowRecord_Start(frames, (uint8_t)keyframeInterval) == false, eCmd_Failed);
+
+		uint32_t	simulateUS = 0;
+		uint32_t	recordUS = 0;
+		uint32_t	keyframeBytes = 0;
+
+		// The same steps UpdateFrame() takes for dynamic ice, leds.show() moves each frame to the display memory the next
+		//	delta is taken against
+		for(int i = 0; i < frames && showRecordFull == false; ++i)
+		{
+			uint32_t	startUS = micros();
+
+			UpdateModel(eFrameIntervalDefaultUS);
+			if(i == 0)
+			{
+				RenderDynamicIce();
+			}
+			else
+			{
+				RenderDynamicIceDirty();
+			}
+			FrameTranspose();
+
+			uint32_t	midUS = micros();
+			uint32_t	bytes = showRecordBytes;
+			bool		keyframe = !ICICLE_DRAW_BUFFER || showRecordKeyNext || showRecordFrame % showKeyframeInterval == 0;
+
+			ShowRecord_Frame(eFrameIntervalDefaultUS);
+
+			simulateUS += midUS - startUS;
+			recordUS += micros() - midUS;
+			if(keyframe)
+			{
+				keyframeBytes += showRecordBytes - bytes;
+			}
+
+			leds.show();
+		}
+
+		uint32_t	recordedFrames = showRecordFrame;
+		uint32_t	recordedBytes = showRecordBytes;
+
+		ShowRecord_Stop();
+
+		if(ShowPlay_Open(0xFFFFFFFF) == false)
+		{
+			inOutput->printf("the show didn't fit in the store\n");
+			return eCmd_Failed;
+		}
+
+		uint32_t	startUS = micros();
+
+		showReadOffset = showKeyframeOffset[0];
+		showPlayFrame = 0;
+		for(uint32_t i = 0; i < showFrameCount; ++i)
+		{
+			ShowPlay_ReadHeader();
+			ShowPlay_Decode();
+		}
+
+		uint32_t	playUS = micros() - startUS;
+
+		inOutput->printf("frames=%lu of %d bytes=%lu bytes/frame=%1.1f ratio=%1.1f:1 keyframe bytes=%lu\n", showFrameCount, frames, recordedBytes, float(recordedBytes) / float(recordedFrames), float(recordedFrames) * float(sizeof(gIcicleLEDDrawMemory)) / float(recordedBytes), keyframeBytes);
+		inOutput->printf("us/frame simulate=%1.1f record=%1.1f playback=%1.1f playback MB/s=%1.1f\n", float(simulateUS) / float(recordedFrames), float(recordUS) / float(recordedFrames), float(playUS) / float(showFrameCount), playUS > 0 ? float(recordedBytes) / float(playUS) : 0.0f);
+
+		frameInvalid = true;
+		frameReady = false;
+		showRecordKeyNext = true;
+
+		return eCmd_Succeeded;
+	}
+
+	uint8_t
+	SimVerify(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		MReturnOnError(inArgC > 3, eCmd_Failed);
+
+		int			frames = inArgC >= 2 ? atoi(inArgV[1]) : eSimCheckpointInterval * eSimCheckpointCount;
+		uint32_t	maxFrameUS = inArgC >= 3 ? (uint32_t)strtoul(inArgV[2], NULL, 0) : eFrameIntervalDefaultUS * settings.frameBudgetPercent / 100;
+
+		MReturnOnError(frames <= 0, eCmd_Failed);
+
+		// Run from the defaults so the result doesn't depend on how this controller is set up
+		SSettings	savedSettings = settings;
+		uint32_t	savedSeed = randomSeed;
+
+		EEPROMInitialize();
+		renderedMode = eRenderMode_DynamicIce;
+		GaussianTables_Build(eGaussianTable_All);
+		DynamicPalette_Build();
+		GammaLUT_Build();
+		RandomSeed(eSimSeed);
+		updateCumulatorUS = 0;
+		DynamicState_Reset();
+
+		// The steps UpdateFrame() takes for dynamic ice at a fixed frame interval, the hashing isn't timed
+		uint32_t	hash = 2166136261UL;
+		uint32_t	elapsedUS = 0;
+		int			mismatchFrame = 0;
+
+		for(int i = 0; i < frames; ++i)
+		{
+			uint32_t	startUS = micros();
+
+			UpdateModel(eFrameIntervalDefaultUS);
+			ParamApply_Update();
+			if(i == 0)
+			{
+				RenderDynamicIce();
+			}
+			else
+			{
+				RenderDynamicIceDirty();
+			}
+			FrameTranspose();
+
+			elapsedUS += micros() - startUS;
+
+			hash = SimHash(hash, (uint32_t const*)gIcicleLEDFrame, sizeof(gIcicleLEDFrame) / 4);
+			hash = SimHash(hash, (uint32_t const*)gIcicleLEDDrawMemory, sizeof(gIcicleLEDDrawMemory) / 4);
+
+			int	checkpoint = (i + 1) / eSimCheckpointInterval - 1;
+
+			if((i + 1) % eSimCheckpointInterval == 0 && checkpoint < eSimCheckpointCount)
+			{
+				bool	match = hash == gSimGoldenHash[checkpoint];
+
+				inOutput->printf("frame %d hash 0x%08lx %s\n", i + 1, hash, eSimGoldenGeometry == false ? "unchecked" : match ? "ok" : "mismatch");
+				if(eSimGoldenGeometry && match == false && mismatchFrame == 0)
+				{
+					mismatchFrame = i + 1;
+				}
+			}
+		}
+
+		settings = savedSettings;
+		renderedMode = 0xFF;
+		GaussianTables_Build(eGaussianTable_All);
+		DynamicPalette_Build();
+		GammaLUT_Build();
+		RandomSeed(savedSeed);
+		DynamicState_Reset();
+		frameReady = false;
+		showRecordKeyNext = true;
+
+		float	frameUS = float(elapsedUS) / float(frames);
+
+		inOutput->printf("%d frames %1.1f us/frame, budget %lu us\n", frames, frameUS, maxFrameUS);
+
+		if(mismatchFrame != 0)
+		{
+			inOutput->printf("output changed by frame %d\n", mismatchFrame);
+			return eCmd_Failed;
+		}
+
+		return frameUS <= float(maxFrameUS) ? eCmd_Succeeded : eCmd_Failed;
+	}
+
+	// FNV-1a over words
+	static uint32_t
+	SimHash(
+		uint32_t		inHash,
+		uint32_t const*	inData,
+		uint32_t		inWords)
+	{
+		for(uint32_t i = 0; i < inWords; ++i)
+		{
+			inHash = (inHash ^ inData[i]) * 16777619UL;
+		}
+
+		return inHash;
+	}
+
+	uint8_t
+	FrameVerify(
+		IOutputDirector*	inOutput,
+		int					inArgC,
+		char const*			inArgV[])
+	{
+		// This only touches the drawing buffer, getPixel() reads the same buffer
+		FrameTranspose();
+
+		int				mismatchCount = 0;
+		uint8_t const*	rgb = gIcicleLEDFrame[0];
+
+		for(int i = 0; i < eLEDsPerStrip * eStripCount; ++i, rgb += 3)
+		{
+			int	expected = (outputLUT[0][rgb[0]] << 16) | (outputLUT[1][rgb[1]] << 8) | outputLUT[2][rgb[2]];
+			int	actual = leds.getPixel(i);
+
+			if(actual != expected)
+			{
+				if(mismatchCount < 8)
+				{
+					inOutput->printf("led %d: expected %06x got %06x\n", i, expected, actual);
+				}
+				++mismatchCount;
+			}
+		}
+
+		inOutput->printf("%d of %d LEDs mismatched\n", mismatchCount, eLEDsPerStrip * eStripCount);
+
+		return mismatchCount == 0 ? eCmd_Succeeded : eCmd_Failed;
+	}
+
+	virtual void
+	EEPROMInitialize(
+		void)
+	{
+		settings.meanGrowRateLEDsPerSec = 0.05f;
+		settings.stdGrowRateLEDsPerSec = 0.025f;
+		settings.meanPeekDepth = 4.0f;
+		settings.stdPeekDepth = 4.0f;
+		settings.meanPeekDepthLifetimeSec = 10.0f;
+		settings.stdPeekDepthLifetimeSec = 2.0f;
+		settings.meanIcicleStartDripTime = 60.0f * 5.0f;
+		settings.stdIcicleStartDripTime = 60.0f * 2.0f;
+		settings.waterDripRatePreLEDsPerSec = 2.0f;
+		settings.waterDripRatePostLEDsPerTick = 4.0f;
+		settings.staticIntensity = 1.0f;
+		settings.gammaR = 1.0f;
+		settings.gammaG = 1.0f;
+		settings.gammaB = 1.0f;
+		settings.growDownColorR = 64;
+		settings.growDownColorG = 64;
+		settings.growDownColorB = 250;
+		settings.recedeUpColorR = 250;
+		settings.recedeUpColorG = 128;
+		settings.recedeUpColorB = 200;
+		settings.waterDripR = 0;
+		settings.waterDripG = 0;
+		settings.waterDripB = 0xFF;
+		settings.staticR = 0xFF;
+		settings.staticG = 0xFF;
+		settings.staticB = 0x80;
+		settings.renderMode = eRenderMode_DynamicIce;
+		settings.framePacing = eFramePacing_Fixed;
+		settings.frameBudgetPercent = 50;
+		settings.frameIntervalUS = eFrameIntervalDefaultUS;
+		settings.webSliceBytes = 256;
+		settings.webSliceUS = eUpdateTimeUS;
+		settings.paramApply = eParamApply_Lazy;
+		settings.paramReseedPerFrame = 8;
+		settings.streamUniverse = 0;
+		settings.streamTimeoutMS = 2000;
+		settings.canNodeIndex = 0;
+		settings.canNodeCount = 1;
+	}
+
+	virtual void
+	Update(
+		uint32_t	inDeltaUS)
+	{
+		// Time already handed to frames run while a page was being sent was part of this delta
+		inDeltaUS = inDeltaUS > webYieldedUS ? inDeltaUS - webYieldedUS : 0;
+		webYieldedUS = 0;
+		lastUpdateUS = micros();
+
+		UpdateTick(inDeltaUS);
+	}
+
+	void
+	UpdateTick(
+		uint32_t	inDeltaUS)
+	{
+		SettingsStore_Update();
+		CAN_Update();
+
+		// The sender paces the stream, its frames go out as soon as they are complete
+		if(Stream_Update())
+		{
+			return;
+		}
+
+		frameElapsedUS += inDeltaUS;
+		if(CAN_Pacing())
+		{
+			// Every node of the roofline presents on the same sync and steps the model by the same delta
+			if(CAN_PresentWait() == false)
+			{
+				return;
+			}
+
+			if(canPresentDeltaUS != 0)
+			{
+				frameElapsedUS = canPresentDeltaUS;
+			}
+		}
+		else if(frameElapsedUS < frameIntervalUS)
+		{
+			return;
+		}
+
+		FrameRun();
+	}
+
+	// Run the frame that is due for the time in frameElapsedUS. Nothing here changes the settings so WebSlice_Yield() can
+	//	run it from inside a page handler
+	void
+	FrameRun(
+		void)
+	{
+		// A frame that starts a whole interval late has missed its deadline, the model steps over all of the elapsed time
+		//	at once instead of catching up one frame at a time
+		if(frameElapsedUS >= frameIntervalUS * 2)
+		{
+			++missedDeadlineCount;
+			coalescedFrameCount += frameElapsedUS / frameIntervalUS - 1;
+		}
+
+		// UpdateModel() converts the delta to 4.12 secs in 32 bits so a stall longer than the longest interval only steps
+		//	the model by that much, the same cap CAN_PresentDelta() puts on the followers
+		if(frameElapsedUS > eFrameIntervalMaxUS)
+		{
+			frameElapsedUS = eFrameIntervalMaxUS;
+		}
+
+		uint32_t	startUS = micros();
+
+		if(framesRunCount > 0 && startUS - frameLastStartUS > frameIntervalMaxUS)
+		{
+			frameIntervalMaxUS = startUS - frameLastStartUS;
+		}
+		frameLastStartUS = startUS;
+
+		frameDMAWaitUS = 0;
+		UpdateFrame(frameElapsedUS);
+		if(showRecording)
+		{
+			ShowRecord_Update(frameElapsedUS);
+		}
+#if !ICICLE_DRAW_BUFFER
+		FramePresent();
+#endif
+		frameElapsedUS = 0;
+
+		// Waiting on the DMA is left out of the cost, the interval never goes below the time it takes
+		FramePacing_Record(micros() - startUS - frameDMAWaitUS);
+	}
+
+	void
+	UpdateFrame(
+		uint32_t	inDeltaUS)
+	{
+		uint8_t	renderMode = ledsOn ? settings.renderMode : (uint8_t)eRenderMode_AllOff;
+
+		if(renderMode != renderedMode)
+		{
+			renderedMode = renderMode;
+			frameInvalid = true;
+			OutputLUT_Build();
+		}
+
+#if ICICLE_DRAW_BUFFER
+		// Latch the frame prepared by the last update first so that it goes out on the update boundary, the
+		//	next frame is then built while this one is being clocked out
+		FramePresent();
+#else
+		// The frame is built in the display memory so the last one has to be out of it, it went out an interval ago
+		//	so this is rarely a wait. FrameRun() presents the frame once it is built
+		FrameDMA_Wait();
+#endif
+
+		if(renderMode == eRenderMode_Playback)
+		{
+			// The recorded frames are already in the DMA layout so there is nothing to render or transpose
+			MPerfStart(renderStart);
+			ShowPlay_Update(inDeltaUS);
+			MPerfEnd(ePerfPhase_Render + renderMode, renderStart);
+			return;
+		}
+
+		if(renderMode == eRenderMode_DynamicIce)
+		{
+			MPerfStart(updateStart);
+			UpdateModel(inDeltaUS);
+			ParamApply_Update();
+			MPerfEnd(ePerfPhase_UpdateModel, updateStart);
+
+			if(frameInvalid == false)
+			{
+				// Only redraw the icicles whose output changed, the rest of the frame is still valid
+				MPerfStart(renderStart);
+				int	dirtyCount = RenderDynamicIceDirty();
+				MPerfEnd(ePerfPhase_RenderDirty, renderStart);
+
+				if(dirtyCount == 0)
+				{
+					++skippedShowCount;
+					return;
+				}
+
+				MPerfStart(transposeStart);
+				FrameTranspose();
+				MPerfEnd(ePerfPhase_Transpose, transposeStart);
+
+				frameReady = true;
+				return;
+			}
+		}
+		else if(frameInvalid == false)
+		{
+			// The other modes draw the same frame every time so it is only drawn when the mode or a setting it reads
+			//	changes, the LEDs latch the last frame sent so there is nothing to refresh
+			++skippedShowCount;
+			return;
+		}
+
+		MPerfStart(renderStart);
+		Render(renderMode);
+		MPerfEnd(ePerfPhase_Render + renderMode, renderStart);
+
+		frameInvalid = false;
+
+		MPerfStart(transposeStart);
+		FrameTranspose();
+		MPerfEnd(ePerfPhase_Transpose, transposeStart);
+
+		frameReady = true;
+	}
+
+	void
+	FramePresent(
+		void)
+	{
+		if(frameReady == false)
+		{
+			return;
+		}
+
+		// leds.show() would spin on the previous frame anyway so time the wait here
+		FrameDMA_Wait();
+
+		MPerfStart(showStart);
+		leds.show();
+		MPerfEnd(ePerfPhase_Show, showStart);
+
+		frameReady = false;
+		++framesSentCount;
+	}
+
+	// Wait for the previous frame to be sent out of the display memory
+	void
+	FrameDMA_Wait(
+		void)
+	{
+		if(leds.busy() == false)
+		{
+			return;
+		}
+
+		uint32_t	startUS = micros();
+		MPerfStart(waitStart);
+
+		while(leds.busy())
+		{
+		}
+
+		MPerfEnd(ePerfPhase_DMAWait, waitStart);
+		uint32_t	waitUS = micros() - startUS;
+
+		frameDMAWaitUS += waitUS;
+		++dmaWaitCount;
+		dmaWaitTotalUS += waitUS;
+		if(waitUS > dmaWaitMaxUS)
+		{
+			dmaWaitMaxUS = waitUS;
+		}
+	}
+
+	// The universes of the strips of this node
+	uint32_t
+	Stream_FirstUniverse(
+		void)
+	{
+		return settings.streamUniverse + uint32_t(settings.canNodeIndex) * eStreamUniverseCount;
+	}
+
+	void
+	Stream_FrameComplete(
+		void)
+	{
+		streamFrameReady = true;
+		streamUniverseMask = 0;
+		streamFrameCompleteUS = micros();
+	}
+
+	// Returns true while the stream has the LEDs, once it times out the set render mode redraws the whole frame
+	bool
+	Stream_Update(
+		void)
+	{
+		if(streamActive == false)
+		{
+			return false;
+		}
+
+		if(ledsOn == false || micros() - streamLastPacketUS >= uint32_t(settings.streamTimeoutMS) * 1000)
+		{
+			streamActive = false;
+			streamSyncSeen = false;
+			streamFrameReady = false;
+			streamUniverseMask = 0;
+			frameElapsedUS = 0;
+			++streamTimeoutCount;
+
+			// Whatever arrived is still in the rows whether it was shown or not, the skipped LEDs included which no
+			//	mode but all off writes, so the set mode starts from a clear frame
+			memset(gIcicleLEDFrame, 0, sizeof(gIcicleLEDFrame));
+			frameInvalid = true;
+
+			return false;
+		}
+
+		if(streamFrameReady)
+		{
+			Stream_Present();
+		}
+
+		// The set mode starts over from here when the stream ends
+		frameElapsedUS = 0;
+
+		return true;
+	}
+
+	// There is nothing to render so the frame is shown on the update it completed by instead of waiting for the interval
+	void
+	Stream_Present(
+		void)
+	{
+		if(renderedMode != eRenderMode_Stream)
+		{
+			renderedMode = eRenderMode_Stream;
+			OutputLUT_Build();
+		}
+
+		MPerfStart(transposeStart);
+		FrameTranspose();
+		MPerfEnd(ePerfPhase_Transpose, transposeStart);
+
+		frameReady = true;
+		FramePresent();
+
+		// The recording never saw this frame so it can't be the base of the next delta
+		showRecordKeyNext = true;
+
+		uint32_t	latencyUS = micros() - streamFrameCompleteUS;
+
+		streamFrameReady = false;
+		++streamFrameCount;
+		streamLatencyTotalUS += latencyUS;
+		if(latencyUS > streamLatencyMaxUS)
+		{
+			streamLatencyMaxUS = latencyUS;
+		}
+	}
+
+	void
+	Stream_ResetStats(
+		void)
+	{
+		streamPacketCount = 0;
+		streamBadPacketCount = 0;
+		streamOverrunCount = 0;
+		streamFrameCount = 0;
+		streamStartCount = 0;
+		streamTimeoutCount = 0;
+		streamLatencyTotalUS = 0;
+		streamLatencyMaxUS = 0;
+		streamStatsStartUS = micros();
+	}
+
+	// Bits on the wire of a standard frame with inLength data bytes and worst case stuffing
+	static uint32_t
+	CAN_FrameBits(
+		uint8_t	inLength)
+	{
+		return 47 + 8 * inLength + (34 + 8 * inLength - 1) / 4;
+	}
+
+	bool
+	CAN_Write(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		if(gCANBusBackend.Write(inId, inLength, inData) == false)
+		{
+			++canWriteFailCount;
+			return false;
+		}
+
+		canBitsSent += CAN_FrameBits(inLength);
+
+		return true;
+	}
+
+	// A controller on its own, or one built without ICICLE_CAN, has no bus to share
+	bool
+	CAN_Active(
+		void)
+	{
+		return ICICLE_CAN && settings.canNodeCount > 1;
+	}
+
+	// Handle whatever arrived from the other nodes and send the settings once they stop changing
+	void
+	CAN_Update(
+		void)
+	{
+		if(CAN_Active() == false)
+		{
+			return;
+		}
+
+		uint16_t	id;
+		uint8_t		length;
+		uint8_t		data[8];
+
+		while(gCANBusBackend.Read(id, length, data))
+		{
+			canBitsReceived += CAN_FrameBits(length);
+
+			if(id == eCANId_Sync)
+			{
+				if(settings.canNodeIndex != 0)
+				{
+					CAN_SyncReceive(length, data);
+				}
+			}
+			else if(id >= eCANId_Settings && id < eCANId_Settings + eCANNodeMax && id != eCANId_Settings + settings.canNodeIndex)
+			{
+				CAN_SettingsReceive(id, length, data);
+			}
+		}
+
+		if(canSettingsPending && micros() - settingsChangedUS >= eCANSettingsQuietUS)
+		{
+			CAN_SettingsSend();
+		}
+	}
+
+	// Returns true while frames are paced by the syncs of node 0 instead of by this node alone
+	bool
+	CAN_Pacing(
+		void)
+	{
+		if(CAN_Active() == false)
+		{
+			return false;
+		}
+
+		if(settings.canNodeIndex == 0)
+		{
+			return true;
+		}
+
+		if(canSynced && micros() - canLastSyncUS >= eCANSyncTimeoutUS)
+		{
+			// Node 0 is gone, it may have restarted with a new clock by the time it is back
+			canSynced = false;
+			canPresentPending = false;
+			canClockSync.Reset();
+			++canFallbackCount;
+		}
+
+		return canSynced;
+	}
+
+	// Returns true once it is time to present the next frame. Node 0 sends the sync for a frame when it is less than
+	//	eCANSyncLeadUS away, then every node waits for the tick before the moment and spins out the rest of it
+	bool
+	CAN_PresentWait(
+		void)
+	{
+		if(settings.canNodeIndex == 0 && canPresentPending == false)
+		{
+			uint32_t	nowUS = micros();
+			int32_t		leadUS = canSynced ? int32_t(canMasterPresentUS + frameIntervalUS - nowUS) : int32_t(eCANSyncLeadUS);
+
+			if(leadUS > eCANSyncLeadUS)
+			{
+				return false;
+			}
+
+			// A frame that is already due still gives the followers a tick to pick up the sync
+			if(leadUS < eCANSyncLeadUS - eUpdateTimeUS)
+			{
+				leadUS = eCANSyncLeadUS - eUpdateTimeUS;
+			}
+
+			canPresentAtUS = nowUS + leadUS;
+			canPresentDeltaUS = canSynced ? CAN_PresentDelta(canPresentAtUS - canMasterPresentUS) : frameIntervalUS;
+			canMasterPresentUS = canPresentAtUS;
+			canSynced = true;
+			canPresentPending = true;
+			++canSyncSequence;
+
+			uint8_t	data[8];
+
+			data[0] = uint8_t(nowUS);
+			data[1] = uint8_t(nowUS >> 8);
+			data[2] = uint8_t(nowUS >> 16);
+			data[3] = uint8_t(nowUS >> 24);
+			data[4] = uint8_t(leadUS);
+			data[5] = uint8_t(leadUS >> 8);
+			data[6] = uint8_t(leadUS >> 16);
+			data[7] = canSyncSequence;
+
+			if(CAN_Write(eCANId_Sync, sizeof(data), data))
+			{
+				++canSyncSentCount;
+			}
+		}
+
+		if(canPresentPending == false)
+		{
+			return false;
+		}
+
+		int32_t	remainingUS = int32_t(canPresentAtUS - micros());
+
+		if(remainingUS >= eUpdateTimeUS)
+		{
+			return false;
+		}
+
+		if(remainingUS < 0)
+		{
+			++canLateCount;
+		}
+
+		// At most one tick, short enough not to hold up the other modules for long
+		while(int32_t(canPresentAtUS - micros()) > 0)
+		{
+		}
+
+		uint32_t	errorUS = micros() - canPresentAtUS;
+
+		if(remainingUS >= 0 && errorUS > canPresentErrorMaxUS)
+		{
+			canPresentErrorMaxUS = errorUS;
+		}
+
+		canPresentPending = false;
+
+		return true;
+	}
+
+	// Every node steps the model by the time between the presents of node 0, a gap such as a stream is capped like a
+	//	frame at the longest interval
+	static uint32_t
+	CAN_PresentDelta(
+		uint32_t	inDeltaUS)
+	{
+		return inDeltaUS < eFrameIntervalMaxUS ? inDeltaUS : eFrameIntervalMaxUS;
+	}
+
+	// A sync is the master send time, the lead from then to the present and the frame sequence
+	void
+	CAN_SyncReceive(
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		uint32_t	receiveUS = micros();
+
+		if(inLength != 8)
+		{
+			++canBadFrameCount;
+			return;
+		}
+
+		uint32_t	sendUS = inData[0] | (inData[1] << 8) | (inData[2] << 16) | (uint32_t(inData[3]) << 24);
+		uint32_t	leadUS = inData[4] | (inData[5] << 8) | (inData[6] << 16);
+		uint8_t		sequence = inData[7];
+		uint32_t	masterPresentUS = sendUS + leadUS;
+		uint32_t	offsetUS = canClockSync.Add(receiveUS - sendUS);
+		bool		inSequence = canSynced && sequence == uint8_t(canSyncSequence + 1);
+
+		if(canSynced && inSequence == false)
+		{
+			canSyncMissedCount += uint8_t(sequence - canSyncSequence - 1);
+		}
+
+		canPresentDeltaUS = inSequence ? CAN_PresentDelta(masterPresentUS - canMasterPresentUS) : 0;
+		canMasterPresentUS = masterPresentUS;
+		canSyncSequence = sequence;
+		canPresentAtUS = masterPresentUS + offsetUS;
+		canPresentPending = true;
+		canLastSyncUS = receiveUS;
+		canSynced = true;
+		++canSyncReceivedCount;
+	}
+
+	// The settings go out as a slot image so the receivers can check them the same way as a slot read back from EEPROM
+	void
+	CAN_SettingsSend(
+		void)
+	{
+		uint32_t	imageBytes = sizeof(canSettingsImage);
+
+		if(canSettingsChunk == 0)
+		{
+			SettingsImage_Build(canSettingsImage);
+		}
+
+		while(canSettingsChunk * eCANSettingsChunkBytes < imageBytes)
+		{
+			uint32_t	offset = canSettingsChunk * eCANSettingsChunkBytes;
+			uint32_t	bytes = imageBytes - offset < eCANSettingsChunkBytes ? imageBytes - offset : eCANSettingsChunkBytes;
+			uint8_t		data[8];
+
+			data[0] = canSettingsChunk;
+			memcpy(data + 1, canSettingsImage + offset, bytes);
+
+			// The rest goes out on the next update
+			if(CAN_Write(uint16_t(eCANId_Settings + settings.canNodeIndex), uint8_t(bytes + 1), data) == false)
+			{
+				return;
+			}
+
+			++canSettingsChunk;
+		}
+
+		canSettingsPending = false;
+		canSettingsChunk = 0;
+		++canSettingsSentCount;
+	}
+
+	void
+	CAN_SettingsReceive(
+		uint16_t		inId,
+		uint8_t			inLength,
+		uint8_t const*	inData)
+	{
+		if(canSettingsAssembly.Add(inId, inLength, inData, canSettingsReceiveImage, sizeof(canSettingsReceiveImage)) == false)
+		{
+			return;
+		}
+
+		SSettings	newSettings;
+
+		if(SettingsImage_Read(canSettingsReceiveImage, &newSettings) == false)
+		{
+			++canBadFrameCount;
+			return;
+		}
+
+		newSettings.canNodeIndex = settings.canNodeIndex;
+		if(SettingsValidate(newSettings) != NULL)
+		{
+			++canBadFrameCount;
+			return;
+		}
+
+		// Applied settings are saved here too but not sent back out
+		canSettingsFromBus = true;
+		SettingsApply(newSettings);
+		canSettingsFromBus = false;
 
-		DynamicState_Reset();
+		++canSettingsAppliedCount;
+	}
 
-		return eCmd_Succeeded;
+	void
+	CAN_Reset(
+		void)
+	{
+		canSynced = false;
+		canPresentPending = false;
+		canSyncSequence = 0;
+		canPresentAtUS = 0;
+		canPresentDeltaUS = 0;
+		canMasterPresentUS = 0;
+		canLastSyncUS = 0;
+		canClockSync.Reset();
+		canSettingsAssembly.Reset();
 	}
 
-	uint8_t
-	PeekDepthDistributionSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	void
+	CAN_ResetStats(
+		void)
 	{
-		MReturnOnError(inArgC != 3, eCmd_Failed);
+		canSyncSentCount = 0;
+		canSyncReceivedCount = 0;
+		canSyncMissedCount = 0;
+		canLateCount = 0;
+		canFallbackCount = 0;
+		canPresentErrorMaxUS = 0;
+		canWriteFailCount = 0;
+		canBadFrameCount = 0;
+		canSettingsSentCount = 0;
+		canSettingsAppliedCount = 0;
+		canBitsSent = 0;
+		canBitsReceived = 0;
+		canStatsStartUS = micros();
+	}
 
-		settings.meanPeekDepth = (float)atof(inArgV[1]);
-		settings.stdPeekDepth = (float)atof(inArgV[2]);
+	bool
+	ShowRecord_Start(
+		uint32_t	inFrames,
+		uint8_t		inKeyframeInterval)
+	{
+		MReturnOnError(settings.renderMode == eRenderMode_Playback || gShowStoreBackend.Create() == false, false);
+
+		uint8_t	header[eShowHeaderSize] = {'I', 'C', 'S', 'H', eShowVersion, inKeyframeInterval, eShowFrameBytes & 0xFF, eShowFrameBytes >> 8};
+
+		showOpen = false;
+		showChecked = false;
+		showScanning = false;
+		showRecording = true;
+		showRecordFull = false;
+		showRecordKeyNext = true;
+		showKeyframeInterval = inKeyframeInterval;
+		showRecordRemaining = inFrames;
+		showRecordFrame = 0;
+		showRecordDelayUS = 0;
+		showRecordBytes = 0;
+		showChunkLength = 0;
+		showKeyframeCount = 0;
+		ShowRecord_Put(header, sizeof(header));
+
+		return true;
+	}
+
+	void
+	ShowRecord_Stop(
+		void)
+	{
+		// A show cut short by a full store has no room for the index, it is found by reading the show instead
+		if(showRecordFull == false && showKeyframeCount > 0)
+		{
+			ShowRecord_PutIndex();
+		}
 
-		EEPROMSave();
+		if(showChunkLength > 0 && gShowStoreBackend.Append(showChunk, showChunkLength) == false)
+		{
+			showRecordFull = true;
+		}
 
-		DynamicState_Reset();
+		gShowStoreBackend.Close();
 
-		return eCmd_Succeeded;
+		// The chunk is used for reading from here on, the show is opened again the next time it is played
+		showRecording = false;
+		showChecked = false;
+		showChunkStart = 0;
+		showChunkLength = 0;
 	}
 
-	uint8_t 
-	PeekDepthLifeDistributionSet(
-		IOutputDirector* inOutput,
-		int inArgC,
-		char const* inArgV[])
+	void
+	ShowRecord_Update(
+		uint32_t	inDeltaUS)
 	{
-		MReturnOnError(inArgC != 3, eCmd_Failed);
+		showRecordDelayUS += inDeltaUS;
 
-		settings.meanPeekDepthLifetimeSec = (float)atof(inArgV[1]);
-		settings.stdPeekDepthLifetimeSec = (float)atof(inArgV[2]);
+		// A frame that didn't change isn't recorded, its time goes to the next one
+		if(frameReady == false)
+		{
+			return;
+		}
 
-		EEPROMSave();
+		ShowRecord_Frame(showRecordDelayUS);
+		showRecordDelayUS = 0;
 
-		DynamicState_Reset();
+		if(--showRecordRemaining == 0 || showRecordFull)
+		{
+			ShowRecord_Stop();
+		}
+	}
 
-		return eCmd_Succeeded;
+	// Record the frame that was just transposed into the drawing buffer. FramePresent() copied the frame before it to the
+	//	display memory so the delta is against that, without another frame sized buffer. Without a draw buffer there is no
+	//	frame before it to take a delta against so every record is a keyframe. Each record is
+	//	- a tag byte, eShowTag_Keyframe or eShowTag_Delta,
+	//	- a varint of the us since the frame before,
+	//	- a varint of the bytes of runs that follow,
+	//	- runs of a varint count of unchanged bytes, a varint count of changed bytes and the changed bytes.
+	//	Keyframes are runs against a black frame so they can be played without the frames before them. A record cut
+	//	short by a full store is dropped when the show is opened. A changed LED only flips its strip's bit in some of its
+	//	24 bytes so the runs are byte sized, word sized runs came out almost twice as big on dynamic ice
+	void
+	ShowRecord_Frame(
+		uint32_t	inDelayUS)
+	{
+		bool			keyframe = !ICICLE_DRAW_BUFFER || showRecordKeyNext || showRecordFrame % showKeyframeInterval == 0;
+		uint8_t const*	reference = keyframe ? NULL : (uint8_t const*)gIcicleLEDDisplayMemory;
+		uint8_t			tag = keyframe ? eShowTag_Keyframe : eShowTag_Delta;
+
+		if(showRecordFrame % showKeyframeInterval == 0 && showKeyframeCount < eShowKeyframeIndexMax)
+		{
+			showKeyframeOffset[showKeyframeCount++] = showRecordBytes;
+		}
+
+		ShowRecord_Put(&tag, 1);
+		ShowRecord_PutVarint<true>(inDelayUS);
+		ShowRecord_PutVarint<true>(ShowRecord_Encode<false>(reference));
+		ShowRecord_Encode<true>(reference);
+
+		showRecordKeyNext = false;
+		++showRecordFrame;
 	}
 
-	uint8_t
-	DripStartTimeDistributionSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	// The index of the keyframes ShowPlay_Seek() starts from follows the last record so playback can find them without
+	//	reading the whole show. It is a tag byte of eShowTag_Index, varints of the frame count, the keyframe count and
+	//	each keyframe's offset, then a footer of the index's own offset as 4 bytes and "ICIX"
+	void
+	ShowRecord_PutIndex(
+		void)
 	{
-		MReturnOnError(inArgC != 3, eCmd_Failed);
+		uint32_t	indexOffset = showRecordBytes;
+		uint8_t		tag = eShowTag_Index;
 
-		settings.meanIcicleStartDripTime = (float)atof(inArgV[1]);
-		settings.stdIcicleStartDripTime = (float)atof(inArgV[2]);
+		ShowRecord_Put(&tag, 1);
+		ShowRecord_PutVarint<true>(showRecordFrame);
+		ShowRecord_PutVarint<true>(showKeyframeCount);
+		for(int i = 0; i < showKeyframeCount; ++i)
+		{
+			ShowRecord_PutVarint<true>(showKeyframeOffset[i]);
+		}
 
-		EEPROMSave();
+		uint8_t	footer[eShowIndexFooterSize] = {uint8_t(indexOffset), uint8_t(indexOffset >> 8), uint8_t(indexOffset >> 16), uint8_t(indexOffset >> 24), 'I', 'C', 'I', 'X'};
 
-		DynamicState_Reset();
+		ShowRecord_Put(footer, sizeof(footer));
+	}
 
-		return eCmd_Succeeded;
+	// Returns the bytes of runs the drawing buffer encodes to against inReference, or against black when it is NULL. The
+	//	runs are only written out when tEmit is true so the size can go ahead of them
+	template<bool tEmit>
+	uint32_t
+	ShowRecord_Encode(
+		uint8_t const*	inReference)
+	{
+		uint8_t const*	frame = (uint8_t const*)gIcicleLEDDrawMemory;
+		uint32_t		bytes = 0;
+		uint32_t		i = 0;
+
+		for(;;)
+		{
+			uint32_t	runStart = i;
+
+			if(inReference != NULL)
+			{
+				while(i < eShowFrameBytes && frame[i] == inReference[i])
+				{
+					++i;
+				}
+			}
+			else
+			{
+				while(i < eShowFrameBytes && frame[i] == 0)
+				{
+					++i;
+				}
+			}
+
+			// The unchanged bytes at the end don't need a run
+			if(i >= eShowFrameBytes)
+			{
+				return bytes;
+			}
+
+			uint32_t	literalStart = i;
+
+			if(inReference != NULL)
+			{
+				while(i < eShowFrameBytes && frame[i] != inReference[i])
+				{
+					++i;
+				}
+			}
+			else
+			{
+				while(i < eShowFrameBytes && frame[i] != 0)
+				{
+					++i;
+				}
+			}
+
+			bytes += ShowRecord_PutVarint<tEmit>(literalStart - runStart);
+			bytes += ShowRecord_PutVarint<tEmit>(i - literalStart);
+			bytes += i - literalStart;
+
+			if(tEmit)
+			{
+				ShowRecord_Put(frame + literalStart, i - literalStart);
+			}
+		}
 	}
 
-	uint8_t
-	DripRateSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	template<bool tEmit>
+	uint32_t
+	ShowRecord_PutVarint(
+		uint32_t	inValue)
 	{
-		MReturnOnError(inArgC != 3, eCmd_Failed);
+		uint8_t		bytes[5];
+		uint32_t	count = 0;
 
-		settings.waterDripRatePreLEDsPerSec = (float)atof(inArgV[1]);
-		settings.waterDripRatePostLEDsPerTick = (float)atof(inArgV[2]);
+		do
+		{
+			bytes[count++] = uint8_t((inValue & 0x7F) | (inValue > 0x7F ? 0x80 : 0));
+			inValue >>= 7;
+		} while(inValue != 0);
 
-		EEPROMSave();
+		if(tEmit)
+		{
+			ShowRecord_Put(bytes, count);
+		}
 
-		DynamicState_Reset();
+		return count;
+	}
 
-		return eCmd_Succeeded;
+	// Writes go through the chunk so the store sees a few large appends instead of many small ones
+	void
+	ShowRecord_Put(
+		void const*	inData,
+		uint32_t	inBytes)
+	{
+		uint8_t const*	data = (uint8_t const*)inData;
+
+		showRecordBytes += inBytes;
+
+		while(inBytes > 0)
+		{
+			uint32_t	bytes = inBytes < uint32_t(eShowChunkSize - showChunkLength) ? inBytes : eShowChunkSize - showChunkLength;
+
+			memcpy(showChunk + showChunkLength, data, bytes);
+			showChunkLength += bytes;
+			data += bytes;
+			inBytes -= bytes;
+
+			if(showChunkLength == eShowChunkSize)
+			{
+				if(gShowStoreBackend.Append(showChunk, showChunkLength) == false)
+				{
+					showRecordFull = true;
+				}
+				showChunkLength = 0;
+			}
+		}
 	}
 
-	uint8_t
-	GrowDownColorSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	// Read at showReadOffset through the chunk, reads bigger than the chunk go straight to their destination
+	uint32_t
+	ShowRead(
+		void*		outData,
+		uint32_t	inBytes)
 	{
-		MReturnOnError(inArgC != 4, eCmd_Failed);
-		
-		settings.growDownColorR = (uint8_t)(atof(inArgV[1]) * 255.0);
-		settings.growDownColorG = (uint8_t)(atof(inArgV[2]) * 255.0);
-		settings.growDownColorB = (uint8_t)(atof(inArgV[3]) * 255.0);
+		uint8_t*	data = (uint8_t*)outData;
+		uint32_t	done = 0;
 
-		EEPROMSave();
+		while(done < inBytes)
+		{
+			uint32_t	chunkOffset = showReadOffset - showChunkStart;
+			uint32_t	bytes;
 
-		return eCmd_Succeeded;
+			if(showReadOffset < showChunkStart || chunkOffset >= showChunkLength)
+			{
+				if(inBytes - done >= eShowChunkSize)
+				{
+					bytes = gShowStoreBackend.Read(showReadOffset, data + done, inBytes - done);
+					if(bytes == 0)
+					{
+						break;
+					}
+
+					showReadOffset += bytes;
+					done += bytes;
+					continue;
+				}
+
+				showChunkStart = showReadOffset;
+				showChunkLength = (uint16_t)gShowStoreBackend.Read(showReadOffset, showChunk, eShowChunkSize);
+				if(showChunkLength == 0)
+				{
+					break;
+				}
+				chunkOffset = 0;
+			}
+
+			bytes = inBytes - done < showChunkLength - chunkOffset ? inBytes - done : showChunkLength - chunkOffset;
+			memcpy(data + done, showChunk + chunkOffset, bytes);
+			showReadOffset += bytes;
+			done += bytes;
+		}
+
+		return done;
+	}
+
+	bool
+	ShowRead_Varint(
+		uint32_t*	outValue)
+	{
+		uint32_t	value = 0;
+
+		for(int shift = 0; shift < 35; shift += 7)
+		{
+			uint8_t	byte;
+
+			if(ShowRead(&byte, 1) != 1)
+			{
+				return false;
+			}
+
+			value |= uint32_t(byte & 0x7F) << shift;
+			if((byte & 0x80) == 0)
+			{
+				*outValue = value;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Check the header and load the keyframe index from the end of the show. A show without one is read through to
+	//	count its frames and find its keyframes, inMaxRecords at a time so the updates aren't held up, and returns false
+	//	until that is done
+	bool
+	ShowPlay_Open(
+		uint32_t	inMaxRecords)
+	{
+		if(showRecording || (showChecked && showScanning == false))
+		{
+			return showOpen;
+		}
+
+		if(showChecked == false)
+		{
+			uint8_t	header[eShowHeaderSize];
+
+			showChecked = true;
+			showOpen = false;
+			showReadOffset = 0;
+			showChunkLength = 0;
+			showFrameCount = 0;
+			showKeyframeCount = 0;
+
+			if(ShowRead(header, sizeof(header)) != sizeof(header) || memcmp(header, "ICSH", 4) != 0 || header[4] != eShowVersion || header[5] == 0 || (header[6] | (header[7] << 8)) != eShowFrameBytes)
+			{
+				return false;
+			}
+
+			showKeyframeInterval = header[5];
+
+			if(ShowPlay_ReadIndex())
+			{
+				return ShowPlay_Opened();
+			}
+
+			showFrameCount = 0;
+			showKeyframeCount = 0;
+			showScanning = true;
+			showScanOffset = eShowHeaderSize;
+		}
+
+		showReadOffset = showScanOffset;
+
+		for(uint32_t i = 0; i < inMaxRecords; ++i)
+		{
+			uint8_t		tag;
+			uint32_t	delayUS;
+			uint32_t	bytes;
+			uint8_t		lastByte;
+
+			if(ShowRead(&tag, 1) != 1 || (tag != eShowTag_Keyframe && tag != eShowTag_Delta) || ShowRead_Varint(&delayUS) == false || ShowRead_Varint(&bytes) == false || bytes == 0)
+			{
+				return ShowPlay_Opened();
+			}
+
+			// Make sure the whole record is there before counting it
+			showReadOffset += bytes - 1;
+			if(ShowRead(&lastByte, 1) != 1)
+			{
+				return ShowPlay_Opened();
+			}
+
+			if(tag == eShowTag_Keyframe && showFrameCount % showKeyframeInterval == 0 && showFrameCount / showKeyframeInterval < eShowKeyframeIndexMax)
+			{
+				showKeyframeOffset[showKeyframeCount++] = showScanOffset;
+			}
+
+			++showFrameCount;
+			showScanOffset = showReadOffset;
+		}
+
+		return false;
+	}
+
+	bool
+	ShowPlay_Opened(
+		void)
+	{
+		// The first frame is always a keyframe
+		showScanning = false;
+		showOpen = showKeyframeCount > 0;
+		showPlayFrame = 0;
+		frameInvalid = true;
+
+		return showOpen;
+	}
+
+	// Returns false if the show has no index at its end or it doesn't add up
+	bool
+	ShowPlay_ReadIndex(
+		void)
+	{
+		uint32_t	size = gShowStoreBackend.Size();
+		uint8_t		footer[eShowIndexFooterSize];
+		uint8_t		tag;
+		uint32_t	keyframeCount;
+
+		if(size < eShowHeaderSize + eShowIndexFooterSize)
+		{
+			return false;
+		}
+
+		showReadOffset = size - eShowIndexFooterSize;
+		if(ShowRead(footer, sizeof(footer)) != sizeof(footer) || memcmp(footer + 4, "ICIX", 4) != 0)
+		{
+			return false;
+		}
+
+		uint32_t	indexOffset = footer[0] | (footer[1] << 8) | (footer[2] << 16) | (uint32_t(footer[3]) << 24);
+
+		if(indexOffset < eShowHeaderSize || indexOffset >= size - eShowIndexFooterSize)
+		{
+			return false;
+		}
+
+		showReadOffset = indexOffset;
+		if(ShowRead(&tag, 1) != 1 || tag != eShowTag_Index || ShowRead_Varint(&showFrameCount) == false || ShowRead_Varint(&keyframeCount) == false || keyframeCount == 0 || keyframeCount > eShowKeyframeIndexMax)
+		{
+			return false;
+		}
+
+		for(showKeyframeCount = 0; showKeyframeCount < keyframeCount; ++showKeyframeCount)
+		{
+			uint32_t	offset;
+
+			if(ShowRead_Varint(&offset) == false || offset < eShowHeaderSize || offset >= indexOffset)
+			{
+				return false;
+			}
+
+			showKeyframeOffset[showKeyframeCount] = offset;
+		}
+
+		return showFrameCount > 0;
+	}
+
+	// Read the header of the next record, going back to the start after the last frame
+	void
+	ShowPlay_ReadHeader(
+		void)
+	{
+		if(showPlayFrame >= showFrameCount)
+		{
+			showReadOffset = showKeyframeOffset[0];
+			showPlayFrame = 0;
+		}
+
+		ShowRead(&showPlayTag, 1);
+		ShowRead_Varint(&showPlayDelayUS);
+		ShowRead_Varint(&showPlayBytes);
+	}
+
+	// Apply the record whose header was just read to the drawing buffer
+	void
+	ShowPlay_Decode(
+		void)
+	{
+		uint8_t*	frame = (uint8_t*)gIcicleLEDDrawMemory;
+		uint32_t	endOffset = showReadOffset + showPlayBytes;
+		uint32_t	position = 0;
+
+		if(showPlayTag == eShowTag_Keyframe)
+		{
+			memset(gIcicleLEDDrawMemory, 0, sizeof(gIcicleLEDDrawMemory));
+		}
+
+		while(showReadOffset < endOffset)
+		{
+			uint32_t	skipBytes;
+			uint32_t	literalBytes;
+
+			if(ShowRead_Varint(&skipBytes) == false || ShowRead_Varint(&literalBytes) == false || position + skipBytes + literalBytes > eShowFrameBytes)
+			{
+				break;
+			}
+
+			position += skipBytes;
+			ShowRead(frame + position, literalBytes);
+			position += literalBytes;
+		}
+
+		showReadOffset = endOffset;
+		++showPlayFrame;
 	}
 
-	uint8_t
-	RecedeUpColorSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	// Decode from the keyframe at or before inFrame up to inFrame
+	void
+	ShowPlay_Seek(
+		uint32_t	inFrame)
 	{
-		MReturnOnError(inArgC != 4, eCmd_Failed);
-		
-		settings.recedeUpColorR = (uint8_t)(atof(inArgV[1]) * 255.0);
-		settings.recedeUpColorG = (uint8_t)(atof(inArgV[2]) * 255.0);
-		settings.recedeUpColorB = (uint8_t)(atof(inArgV[3]) * 255.0);
+		inFrame %= showFrameCount;
 
-		EEPROMSave();
+		uint32_t	keyframe = inFrame / showKeyframeInterval;
 
-		return eCmd_Succeeded;
+		if(keyframe >= showKeyframeCount)
+		{
+			keyframe = showKeyframeCount - 1;
+		}
+
+		showReadOffset = showKeyframeOffset[keyframe];
+		showPlayFrame = keyframe * showKeyframeInterval;
+
+		do
+		{
+			ShowPlay_ReadHeader();
+			ShowPlay_Decode();
+		} while(showPlayFrame <= inFrame);
+
+		ShowPlay_ReadHeader();
+		showPlayElapsedUS = 0;
 	}
 
-	uint8_t
-	StaticColorSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	void
+	ShowPlay_Update(
+		uint32_t	inDeltaUS)
 	{
-		MReturnOnError(inArgC != 4, eCmd_Failed);
-		
-		settings.staticR = (uint8_t)(atof(inArgV[1]) * 255.0);
-		settings.staticG = (uint8_t)(atof(inArgV[2]) * 255.0);
-		settings.staticB = (uint8_t)(atof(inArgV[3]) * 255.0);
+		if(showRecording)
+		{
+			ShowRecord_Stop();
+		}
 
-		EEPROMSave();
+		if(ShowPlay_Open(eShowScanRecordsPerUpdate) == false)
+		{
+			// There is nothing to play, or it isn't indexed yet, so stay dark
+			if(frameInvalid)
+			{
+				memset(gIcicleLEDDrawMemory, 0, sizeof(gIcicleLEDDrawMemory));
+				frameInvalid = false;
+				frameReady = true;
+			}
+			return;
+		}
 
-		return eCmd_Succeeded;
+		// The drawing buffer was used for something else so start over from a keyframe
+		if(frameInvalid)
+		{
+			ShowPlay_Seek(showPlayFrame > 0 ? showPlayFrame - 1 : 0);
+			frameInvalid = false;
+			frameReady = true;
+			return;
+		}
+
+		// Every delta builds on the one before so a late update decodes all of the frames it missed
+		showPlayElapsedUS += inDeltaUS;
+		while(showPlayElapsedUS >= showPlayDelayUS)
+		{
+			showPlayElapsedUS -= showPlayDelayUS;
+			ShowPlay_Decode();
+			ShowPlay_ReadHeader();
+			frameReady = true;
+		}
 	}
 
-	uint8_t
-	StaticIntensitySet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	void
+	FramePacing_Record(
+		uint32_t	inCostUS)
 	{
-		MReturnOnError(inArgC != 2, eCmd_Failed);
-		
-		settings.staticIntensity = (float)atof(inArgV[1]);
+		++framesRunCount;
+		if(inCostUS > frameCostMaxUS)
+		{
+			frameCostMaxUS = inCostUS;
+		}
 
-		EEPROMSave();
+		// Average over roughly the last 8 frames so one slow frame doesn't swing the interval
+		frameCostAvgUS = (frameCostAvgUS * 7 + inCostUS) / 8;
 
-		return eCmd_Succeeded;
+		FramePacing_Apply();
 	}
 
-	uint8_t
-	RenderModeSet(
-		IOutputDirector*	inOutput,
-		int					inArgC,
-		char const*			inArgV[])
+	void
+	FramePacing_Apply(
+		void)
 	{
-		MReturnOnError(inArgC != 2, eCmd_Failed);
-
-		int i;
-		for(i = 0; i < eRenderMode_Count; ++i)
+		if(settings.framePacing != eFramePacing_Adaptive)
 		{
-			if (strcmp(inArgV[1], gRenderModeStr[i]) == 0)
-			{
-				settings.renderMode = (uint8_t)i;
-				break;
-			}
+			frameIntervalUS = settings.frameIntervalUS;
+			return;
 		}
 
-		if(i >= eRenderMode_Count)
+		// Leave the rest of each interval to the other modules
+		uint32_t	intervalUS = frameCostAvgUS * 100 / settings.frameBudgetPercent;
+
+		if(intervalUS < eFrameIntervalMinUS)
 		{
-			return eCmd_Failed;
+			intervalUS = eFrameIntervalMinUS;
+		}
+		else if(intervalUS > settings.frameIntervalUS)
+		{
+			intervalUS = settings.frameIntervalUS;
 		}
 
-		EEPROMSave();
-
-		return eCmd_Succeeded;
+		frameIntervalUS = intervalUS;
 	}
 
-	virtual void
-	EEPROMInitialize(
+	void
+	FramePacing_ResetStats(
 		void)
 	{
-		settings.meanGrowRateLEDsPerSec = 0.05f;
-		settings.stdGrowRateLEDsPerSec = 0.025f;
-		settings.meanPeekDepth = 4.0f;
-		settings.stdPeekDepth = 4.0f;
-		settings.meanPeekDepthLifetimeSec = 10.0f;
-		settings.stdPeekDepthLifetimeSec = 2.0f;
-		settings.meanIcicleStartDripTime = 60.0f * 5.0f;
-		settings.stdIcicleStartDripTime = 60.0f * 2.0f;
-		settings.waterDripRatePreLEDsPerSec = 2.0f;
-		settings.waterDripRatePostLEDsPerTick = 4.0f;
-		settings.staticIntensity = 1.0f;
-		settings.growDownColorR = 64;
-		settings.growDownColorG = 64;
-		settings.growDownColorB = 250;
-		settings.recedeUpColorR = 250;
-		settings.recedeUpColorG = 128;
-		settings.recedeUpColorB = 200;
-		settings.waterDripR = 0;
-		settings.waterDripG = 0;
-		settings.waterDripB = 0xFF;
-		settings.staticR = 0xFF;
-		settings.staticG = 0xFF;
-		settings.staticB = 0x80;
-		settings.renderMode = eRenderMode_DynamicIce;
+		framesRunCount = 0;
+		missedDeadlineCount = 0;
+		coalescedFrameCount = 0;
+		frameCostAvgUS = 0;
+		frameCostMaxUS = 0;
+		frameIntervalMaxUS = 0;
+		pacingStatsStartUS = micros();
 	}
 
-	virtual void
-	Update(
-		uint32_t	inDeltaUS)
+	void
+	PerfStats_Reset(
+		void)
 	{
-		if(ledsOn == false)
+#if ICICLE_PERF_STATS
+		for(int i = 0; i < ePerfPhase_Count; ++i)
 		{
-			for(int i = 0; i < eLEDsPerStrip * 8; ++i)
-			{
-				leds.setPixel(i, 0, 0, 0);
-			}
-			leds.show();
+			perfStats[i].Reset();
 		}
-		else
+#endif
+	}
+
+#if ICICLE_PERF_STATS
+	float
+	PerfCyclesToUS(
+		uint64_t	inCycles)
+	{
+		return float(inCycles) / float(MPerfCyclesPerUS);
+	}
+#endif
+
+	void
+	Render(
+		uint8_t	inRenderMode)
+	{
+		switch(inRenderMode)
 		{
-			switch(settings.renderMode)
-			{
-				case eRenderMode_StaticIce:
-					RenderStaticIce();
-					break;
+			case eRenderMode_StaticIce:
+				RenderStaticIce();
+				break;
 
-				case eRenderMode_DynamicIce:
-					UpdateModel(inDeltaUS);
-					RenderDynamicIce();
-					break;
+			case eRenderMode_DynamicIce:
+				RenderDynamicIce();
+				break;
 
-				case eRenderMode_AllOn:
-					RenderAllOn();
-					break;
+			case eRenderMode_AllOn:
+				RenderAllOn();
+				break;
 
-				case eRenderMode_AllOff:
-					RenderAllOff();
-					break;
+			case eRenderMode_AllOff:
+				RenderAllOff();
+				break;
 
-				case eRenderMode_Festive:
-					RenderFestive();
-					break;
+			case eRenderMode_Festive:
+				RenderFestive();
+				break;
 
-				case eRenderMode_Strand:
-					RenderStrand();
-					break;
-			}
+			case eRenderMode_Strand:
+				RenderStrand();
+				break;
 		}
 	}
 
@@ -549,12 +5819,89 @@ private:
 		uint16_t	updateSec4dot12 = uint16_t(updateCumulatorUS * (1 << 12) / 1000000);
 		if(updateSec4dot12 >= (1 << 6))
 		{
-			for(int i = 0; i < eIcicleTotal; ++i)
+			icicles.UpdateIcicleStates(updateSec4dot12, dirtyIcicles, this);
+
+			updateCumulatorUS -= uint32_t(updateSec4dot12) * 1000000u / (1 << 12);
+		}
+	}
+
+	inline void
+	SetPixel(
+		uint16_t	inLEDIndex,
+		uint8_t		inR,
+		uint8_t		inG,
+		uint8_t		inB)
+	{
+		// The strip rows are contiguous so the physical LED index addresses the whole frame
+		uint8_t*	rgb = gIcicleLEDFrame[0] + inLEDIndex * 3;
+
+		rgb[0] = inR;
+		rgb[1] = inG;
+		rgb[2] = inB;
+	}
+
+	// The gamma curve of each channel, only rebuilt when the gamma changes since it is the only part that needs floats
+	void
+	GammaLUT_Build(
+		void)
+	{
+		float const	gamma[3] = {settings.gammaR, settings.gammaG, settings.gammaB};
+
+		gammaLUTIdentity = true;
+		for(int c = 0; c < 3; ++c)
+		{
+			for(int v = 0; v < 256; ++v)
+			{
+				gammaLUT[c][v] = gamma[c] == 1.0f ? uint8_t(v) : uint8_t(255.0f * powf(float(v) / 255.0f, gamma[c]) + 0.5f);
+			}
+			gammaLUTIdentity = gammaLUTIdentity && gamma[c] == 1.0f;
+		}
+
+		OutputLUT_Build();
+	}
+
+	// The render modes draw full intensity linear color and this scales it by the brightness of the mode on the way to
+	//	the DMA buffer. Dynamic ice and the stream are always at full brightness, the other modes use the static intensity
+	void
+	OutputLUT_Build(
+		void)
+	{
+		uint32_t	brightness8 = 0x100;
+
+		if(renderedMode != eRenderMode_DynamicIce && renderedMode != eRenderMode_Stream)
+		{
+			float	intensity = settings.staticIntensity;
+
+			brightness8 = intensity <= 0.0f ? 0 : intensity >= 1.0f ? 0x100 : uint32_t(intensity * 256.0f);
+		}
+
+		for(int c = 0; c < 3; ++c)
+		{
+			for(int v = 0; v < 256; ++v)
 			{
-				icicles[i].UpdateIcicleState(updateSec4dot12, this);
+				outputLUT[c][v] = uint8_t((gammaLUT[c][v] * brightness8) >> 8);
 			}
+		}
+
+		outputLUTIdentity = gammaLUTIdentity && brightness8 == 0x100;
+		frameInvalid = true;
+	}
+
+	void
+	FrameTranspose(
+		void)
+	{
+#if !ICICLE_DRAW_BUFFER
+		FrameDMA_Wait();
+#endif
 
-			updateCumulatorUS -= updateSec4dot12 * 1000000 / (1 << 12);
+		if(outputLUTIdentity)
+		{
+			SIcicleKernels<SInstallGeometry>::Transpose<false>(gIcicleLEDFrame, outputLUT, (uint32_t*)gIcicleLEDDrawMemory);
+		}
+		else
+		{
+			SIcicleKernels<SInstallGeometry>::Transpose<true>(gIcicleLEDFrame, outputLUT, (uint32_t*)gIcicleLEDDrawMemory);
 		}
 	}
 
@@ -562,14 +5909,12 @@ private:
 	RenderStaticIce(
 		void)
 	{
-		uint8_t	staticR = (uint8_t)((float)settings.staticR * settings.staticIntensity);
-		uint8_t	staticG = (uint8_t)((float)settings.staticG * settings.staticIntensity);
-		uint8_t	staticB = (uint8_t)((float)settings.staticB * settings.staticIntensity);
+		uint8_t	staticR = settings.staticR;
+		uint8_t	staticG = settings.staticG;
+		uint8_t	staticB = settings.staticB;
 
 		for(int i = 0; i < eIcicleTotal; ++i)
 		{
-			int	ledIndex;
-
 			uint8_t	depth;
 			
 			static uint8_t	gTable[] = {2, 3, 4, 2, 3};
@@ -577,17 +5922,9 @@ private:
 
 			for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
 			{
-				if((i & 1) == 1)
-				{
-					// odd icicles have reverse ordering
-					ledIndex = (i + 1) * eLEDsPerIcicle - j - 1;
-				}
-				else
-				{
-					ledIndex = i * eLEDsPerIcicle + j;
-				}
+				uint32_t	ledIndex = IcicleLEDMap_LED(gIcicleLEDMap[i], j);
 
-				MAssert(ledIndex < eLEDsPerStrip * 8);
+				MAssert(ledIndex < eLEDsPerStrip * eStripCount);
 
 				uint8_t	r, g, b;
 
@@ -602,244 +5939,209 @@ private:
 					r = 0; g = 0; b = 0;
 				}
 
-				leds.setPixel(ledIndex, r, g, b);
+				SetPixel(uint16_t(ledIndex), r, g, b);
 			}
 		}
-
-		leds.show();
 	}
 
 	void
 	RenderAllOn(
 		void)
 	{
-		uint8_t	staticR = (uint8_t)((float)settings.staticR * settings.staticIntensity);
-		uint8_t	staticG = (uint8_t)((float)settings.staticG * settings.staticIntensity);
-		uint8_t	staticB = (uint8_t)((float)settings.staticB * settings.staticIntensity);
+		uint8_t	staticR = settings.staticR;
+		uint8_t	staticG = settings.staticG;
+		uint8_t	staticB = settings.staticB;
 
 		for(int i = 0; i < eIcicleTotal; ++i)
 		{
-			int	ledIndex;
-
 			for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
 			{
-				if((i & 1) == 1)
-				{
-					// odd icicles have reverse ordering
-					ledIndex = (i + 1) * eLEDsPerIcicle - j - 1;
-				}
-				else
-				{
-					ledIndex = i * eLEDsPerIcicle + j;
-				}
-
-				leds.setPixel(ledIndex, staticR, staticG, staticB);
+				SetPixel(uint16_t(IcicleLEDMap_LED(gIcicleLEDMap[i], j)), staticR, staticG, staticB);
 			}
 		}
-		leds.show();
 	}
 
 	void
 	RenderAllOff(
 		void)
 	{
+		// This also clears the skipped LEDs which no other mode writes
+		memset(gIcicleLEDFrame, 0, sizeof(gIcicleLEDFrame));
+	}
+
+	void
+	RenderFestive(
+		void)
+	{
+		uint8_t	r[eLEDsPerIcicle], g[eLEDsPerIcicle], b[eLEDsPerIcicle];
+
+		for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
+		{
+			r[j] = (uint8_t)(gColorTable[j].r * 255.0f);
+			g[j] = (uint8_t)(gColorTable[j].g * 255.0f);
+			b[j] = (uint8_t)(gColorTable[j].b * 255.0f);
+		}
+
 		for(int i = 0; i < eIcicleTotal; ++i)
 		{
-			int	ledIndex;
-			
 			for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
 			{
-				if((i & 1) == 1)
-				{
-					// odd icicles have reverse ordering
-					ledIndex = (i + 1) * eLEDsPerIcicle - j - 1;
-				}
-				else
-				{
-					ledIndex = i * eLEDsPerIcicle + j;
-				}
-
-				leds.setPixel(ledIndex, 0, 0, 0);
+				SetPixel(uint16_t(IcicleLEDMap_LED(gIcicleLEDMap[i], j)), r[j], g[j], b[j]);
 			}
 		}
-		leds.show();
 	}
 
 	void
-	RenderFestive(
+	RenderStrand(
 		void)
 	{
-		for(int i = 0; i < eIcicleTotal; ++i)
+		for(int i = 0; i < eStripCount; ++i)
 		{
-			int	ledIndex;
-			
-			for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
+			uint8_t	r, g, b;
+
+			r = (uint8_t)(gColorTable[i].r * 255.0f);
+			g = (uint8_t)(gColorTable[i].g * 255.0f);
+			b = (uint8_t)(gColorTable[i].b * 255.0f);
+
+			// The icicles of a strip are contiguous in the map
+			for(int j = i * eIciclesPerStrip; j < (i + 1) * eIciclesPerStrip; ++j)
 			{
-				if((i & 1) == 1)
+				for(uint32_t k = 0; k < eLEDsPerIcicle; ++k)
 				{
-					// odd icicles have reverse ordering
-					ledIndex = (i + 1) * eLEDsPerIcicle - j - 1;
+					SetPixel(uint16_t(IcicleLEDMap_LED(gIcicleLEDMap[j], k)), r, g, b);
 				}
-				else
-				{
-					ledIndex = i * eLEDsPerIcicle + j;
-				}
-
-				uint8_t	r, g, b;
-
-				r = (uint8_t)(gColorTable[j].r * settings.staticIntensity * 255.0f);
-				g = (uint8_t)(gColorTable[j].g * settings.staticIntensity * 255.0f);
-				b = (uint8_t)(gColorTable[j].b * settings.staticIntensity * 255.0f);
-
-				leds.setPixel(ledIndex, r, g, b);
 			}
 		}
-		leds.show();
 	}
 
 	void
-	RenderStrand(
+	RenderDynamicIce(
 		void)
 	{
-		for(int i = 0; i < eStripCount; ++i)
+		for(int i = 0; i < eIcicleTotal; ++i)
 		{
-			uint8_t	r, g, b;
+			RenderDynamicIcicle(i);
+		}
 
-			r = (uint8_t)(gColorTable[i].r * settings.staticIntensity * 255.0f);
-			g = (uint8_t)(gColorTable[i].g * settings.staticIntensity * 255.0f);
-			b = (uint8_t)(gColorTable[i].b * settings.staticIntensity * 255.0f);
+		memset(dirtyIcicles, 0, sizeof(dirtyIcicles));
+	}
 
-			for(int j = 0; j < eLEDsPerStrip; ++j)
+	int
+	RenderDynamicIceDirty(
+		void)
+	{
+		int	renderCount = 0;
+
+		for(int i = 0; i < (eIcicleTotal + 31) / 32; ++i)
+		{
+			uint32_t	dirtyBits = dirtyIcicles[i];
+
+			while(dirtyBits != 0)
 			{
-				leds.setPixel(i * eLEDsPerStrip + j, r, g, b);
+				int	bit = __builtin_ctz(dirtyBits);
+
+				dirtyBits &= dirtyBits - 1;
+				RenderDynamicIcicle(i * 32 + bit);
+				++renderCount;
 			}
+
+			dirtyIcicles[i] = 0;
+		}
+
+		dirtyIcicleCount += renderCount;
+		++dirtyFrameCount;
+
+		return renderCount;
+	}
+
+	// Blend the grow down color into the recede up color for every step of the max depth transition, and scale the drip
+	//	color by every coverage, so RenderDynamicIcicle() only looks colors up. Call this when any of the colors change
+	void
+	DynamicPalette_Build(
+		void)
+	{
+		for(uint32_t i = 0; i <= 0x100; ++i)
+		{
+			icePalette8dot8[i][0] = uint16_t(settings.growDownColorR * (0x100 - i) + settings.recedeUpColorR * i);
+			icePalette8dot8[i][1] = uint16_t(settings.growDownColorG * (0x100 - i) + settings.recedeUpColorG * i);
+			icePalette8dot8[i][2] = uint16_t(settings.growDownColorB * (0x100 - i) + settings.recedeUpColorB * i);
+
+			dripPalette8dot8[i][0] = uint16_t(settings.waterDripR * i);
+			dripPalette8dot8[i][1] = uint16_t(settings.waterDripG * i);
+			dripPalette8dot8[i][2] = uint16_t(settings.waterDripB * i);
 		}
-		leds.show();
 	}
 
 	void
-	RenderDynamicIce(
-		void)
+	RenderDynamicIcicle(
+		int	inIcicle)
 	{
-		SIcicleState*	curState = icicles;
+		SIcicleStates*	curState = &icicles;
 
-		for(int i = 0; i < eIcicleTotal; ++i, ++curState)
-		{
-			int	ledIndex;
+		uint32_t	curDepthMag = curState->curDepth4dot12[inIcicle] >> 12;
+		uint32_t	curDepthFrac8 = (curState->curDepth4dot12[inIcicle] >> 4) & 0xFF;
 
-			uint32_t	curDepthMag = curState->curDepth4dot12 >> 12;
-			uint32_t	curDepthFrac8 = (curState->curDepth4dot12 >> 4) & 0xFF;
+		uint32_t	dripLEDAMag = 0xFFFF;
+		uint32_t	dripLEDBMag = 0xFFFF;
+		uint32_t	dripLEDAFrac8 = 0;
+		uint32_t	dripLEDBFrac8 = 0;
 
-			uint32_t	dripLEDAMag = 0xFFFF;
-			uint32_t	dripLEDBMag = 0xFFFF;
-			uint32_t	dripLEDAFrac8 = 0;
-			uint32_t	dripLEDBFrac8 = 0;
+		if(curState->waterDripLoc4dot12[inIcicle] > 0)
+		{
+			// This icicle is dripping water
+			uint16_t	waterDripLoc4dot8 = curState->waterDripLoc4dot12[inIcicle] >> 4;
 
-			if(curState->waterDripLoc4dot12 > 0)
+			if(waterDripLoc4dot8 > 0x7F)
 			{
-				// This icicle is dripping water
-				uint16_t	waterDripLoc4dot8 = curState->waterDripLoc4dot12 >> 4;
-
-				if(waterDripLoc4dot8 > 0x7F)
-				{
-					// Since the drip location is more than half way down an LED we can alias it across two LEDs for a smoother effect.
+				// Since the drip location is more than half way down an LED we can alias it across two LEDs for a smoother effect.
 
-					// Treat the water drip location as the center with half of its LED effect before the location and half after the location
-					dripLEDAFrac8 = waterDripLoc4dot8 - 0x7F;
-					dripLEDAMag = dripLEDAFrac8 >> 8;
-					dripLEDAFrac8 = 0x100 - (dripLEDAFrac8 & 0xFF);
+				// Treat the water drip location as the center with half of its LED effect before the location and half after the location
+				dripLEDAFrac8 = waterDripLoc4dot8 - 0x7F;
+				dripLEDAMag = dripLEDAFrac8 >> 8;
+				dripLEDAFrac8 = 0x100 - (dripLEDAFrac8 & 0xFF);
 
-					dripLEDBFrac8 = waterDripLoc4dot8 + 0x7F;
-					dripLEDBMag = dripLEDBFrac8 >> 8;
-					dripLEDBFrac8 &= 0xFF;
-				}
-				else
-				{
-					// The drip location is less then half way down the first LED so only consider its effect on that LED
-					dripLEDAMag = 0;
-					dripLEDAFrac8 = waterDripLoc4dot8 & 0xFF;
-				}
+				dripLEDBFrac8 = waterDripLoc4dot8 + 0x7F;
+				dripLEDBMag = dripLEDBFrac8 >> 8;
+				dripLEDBFrac8 &= 0xFF;
 			}
-
-			for(uint32_t j = 0; j < eLEDsPerIcicle; ++j)
+			else
 			{
-				if((i & 1) == 1)
-				{
-					// odd icicles have reverse ordering
-					ledIndex = (i + 1) * eLEDsPerIcicle - j - 1;
-				}
-				else
-				{
-					ledIndex = i * eLEDsPerIcicle + j;
-				}
-
-				uint32_t	r8dot8, g8dot8, b8dot8;
-
-				if(j <= curDepthMag)
-				{
-					// j is within the icicle
-
-					if(curState->curMaxDepthLifeTime4dot12 > 0)
-					{
-						uint32_t	maxDepthTransition8dot8 = (uint32_t(curState->curMaxDepthLifeTime4dot12) << 8) / uint32_t(curState->maxDepthLifeTime4dot12);
-						// We are transitioning from grow down to recede up
-						r8dot8 = settings.growDownColorR * (0x100 - maxDepthTransition8dot8) + settings.recedeUpColorR * maxDepthTransition8dot8;
-						g8dot8 = settings.growDownColorG * (0x100 - maxDepthTransition8dot8) + settings.recedeUpColorG * maxDepthTransition8dot8;
-						b8dot8 = settings.growDownColorB * (0x100 - maxDepthTransition8dot8) + settings.recedeUpColorB * maxDepthTransition8dot8;
-					}
-					else
-					{
-						// The icicle is either growing down or receding up
-						if(!(curState->growthRateLEDsPerSec4dot12 & 0x8000))
-						{
-							r8dot8 = settings.growDownColorR << 8;
-							g8dot8 = settings.growDownColorG << 8;
-							b8dot8 = settings.growDownColorB << 8;
-						}
-						else
-						{
-							r8dot8 = settings.recedeUpColorR << 8;
-							g8dot8 = settings.recedeUpColorG << 8;
-							b8dot8 = settings.recedeUpColorB << 8;
-						}
-					}
-						
-					if(j == curDepthMag)
-					{
-						r8dot8 = (r8dot8 * curDepthFrac8) >> 8;
-						g8dot8 = (g8dot8 * curDepthFrac8) >> 8;
-						b8dot8 = (b8dot8 * curDepthFrac8) >> 8;
-					}
-
-					if(j == dripLEDAMag)
-					{
-						r8dot8 = ((r8dot8 * (0x100 - dripLEDAFrac8)) >> 8) + (settings.waterDripR * dripLEDAFrac8);
-						g8dot8 = ((g8dot8 * (0x100 - dripLEDAFrac8)) >> 8) + (settings.waterDripG * dripLEDAFrac8);
-						b8dot8 = ((b8dot8 * (0x100 - dripLEDAFrac8)) >> 8) + (settings.waterDripB * dripLEDAFrac8);
-					}
-					else if(j == dripLEDBMag)
-					{
-						r8dot8 = ((r8dot8 * (0x100 - dripLEDBFrac8)) >> 8) + (settings.waterDripR * dripLEDBFrac8);
-						g8dot8 = ((g8dot8 * (0x100 - dripLEDBFrac8)) >> 8) + (settings.waterDripG * dripLEDBFrac8);
-						b8dot8 = ((b8dot8 * (0x100 - dripLEDBFrac8)) >> 8) + (settings.waterDripB * dripLEDBFrac8);
-					}
-				}
-				else
-				{
-					// j is past the end of the icicle
-					r8dot8 = g8dot8 = b8dot8 = 0;
-				}
+				// The drip location is less then half way down the first LED so only consider its effect on that LED
+				dripLEDAMag = 0;
+				dripLEDAFrac8 = waterDripLoc4dot8 & 0xFF;
+			}
+		}
 
-				if(r8dot8 > 0xFFFF) r8dot8 = 0xFFFF;
-				if(g8dot8 > 0xFFFF) g8dot8 = 0xFFFF;
-				if(b8dot8 > 0xFFFF) b8dot8 = 0xFFFF;
+		// The whole icicle is one color from the palette, from the grow down color through the max depth transition to the
+		//	recede up color
+		uint32_t	paletteIndex;
 
-				MAssert(ledIndex < eLEDsPerStrip * 8);
-				leds.setPixel(ledIndex, uint8_t(r8dot8 >> 8), uint8_t(g8dot8 >> 8), uint8_t(b8dot8 >> 8));
+		if(curState->IsHolding(inIcicle))
+		{
+			paletteIndex = curState->GetHoldTransition8dot8(inIcicle, curState->modelTime4dot12);
+			if(paletteIndex > 0x100)
+			{
+				paletteIndex = 0x100;
 			}
 		}
+		else
+		{
+			paletteIndex = (curState->growthRateLEDsPerSec4dot12[inIcicle] & 0x8000) ? 0x100 : 0;
+		}
 
-		leds.show();
+		SIcicleDraw	draw;
+
+		draw.depthMag = curDepthMag;
+		draw.depthFrac8 = curDepthFrac8;
+		draw.dripAMag = dripLEDAMag;
+		draw.dripBMag = dripLEDBMag;
+		draw.dripAFrac8 = dripLEDAFrac8;
+		draw.dripBFrac8 = dripLEDBFrac8;
+		draw.iceColor8dot8 = icePalette8dot8[paletteIndex];
+		draw.dripColorA8dot8 = dripPalette8dot8[dripLEDAFrac8];
+		draw.dripColorB8dot8 = dripPalette8dot8[dripLEDBFrac8];
+
+		SIcicleKernels<SInstallGeometry>::RenderIcicle(draw, gIcicleLEDMap[inIcicle], gIcicleLEDFrame[0]);
 	}
 
 	struct SSettings
@@ -869,6 +6171,9 @@ private:
 		// This is the intensity of the static color render mode
 		float	staticIntensity;
 
+		// This is the gamma of each color channel applied to every render mode at the output
+		float	gammaR, gammaG, gammaB;
+
 		// This is the base color for icicles growing down
 		uint8_t	growDownColorR, growDownColorG, growDownColorB;
 
@@ -882,183 +6187,873 @@ private:
 		uint8_t	staticR, staticG, staticB;
 
 		uint8_t	renderMode;
+
+		// Fixed pacing starts a frame every frameIntervalUS, adaptive pacing runs as fast as frameBudgetPercent of the
+		//	time allows but never slower than frameIntervalUS
+		uint8_t		framePacing;
+		uint8_t		frameBudgetPercent;
+		uint32_t	frameIntervalUS;
+
+		// Pages are sent in slices of at most webSliceBytes with due frames run in between, 0 sends them in one piece.
+		//	The slices are sized to take the client about webSliceUS each, 0 keeps them all webSliceBytes
+		uint16_t	webSliceBytes;
+		uint16_t	webSliceUS;
+
+		// Reset restarts the dynamic ice when a distribution changes, lazy lets the icicles pick it up as they go and
+		//	resamples paramReseedPerFrame icicles a frame to speed that up
+		uint8_t		paramApply;
+		uint8_t		paramReseedPerFrame;
+
+		// Art-Net universes streamUniverse and up drive the strips of every node in order, the stream hands the LEDs back to the set
+		//	render mode when no packet has come for streamTimeoutMS
+		uint16_t	streamUniverse;
+		uint16_t	streamTimeoutMS;
+
+		// This controller drives shard canNodeIndex of a roofline of canNodeCount controllers, node 0 paces the frames
+		//	of the others. Settings from another node replace everything but canNodeIndex
+		uint8_t		canNodeIndex;
+		uint8_t		canNodeCount;
 	};
 
-	struct SIcicleState
+	// The icicle simulation is stored as one array per field so the update kernel can step several icicles at once. Only icicles
+	//	that are growing, receding or dripping are stepped each tick, the end of a hold at max depth and the start of a drip are
+	//	events on a timing wheel that are handled on the tick they come due.
+	struct __attribute__((aligned(16))) SIcicleStates
 	{
+		enum
+		{
+			// Pad every field to a whole number of 8 lane vectors
+			eLaneTotal = (eIcicleTotal + 7) & ~7,
+			eBitWords = (eIcicleTotal + 31) / 32,
+
+			// Each slot covers 1/32 sec so the wheel turns every 8 secs, events further out stay in their slot for more turns
+			eWheelSlotCount = 256,
+			eWheelSlotShift = 7,
+
+			// Event node n < eIcicleTotal is the end of the hold of icicle n, the rest are the drip starts
+			eEventNode_HoldEnd = 0,
+			eEventNode_DripStart = eIcicleTotal,
+			eEventNode_Count = eIcicleTotal * 2,
+			eEventNode_None = 0xFFFF,
+		};
+
+		// Depths are signed 4.12 and the render key keeps 11 bits of them in 4.8, longer icicles need a wider model
+		static_assert(eLEDsPerIcicle <= 7, "the icicle model covers up to 7 LEDs per icicle");
+		static_assert(eEventNode_Count <= eEventNode_None, "event nodes are 16 bits");
+
+		void
+		Reset(
+			void)
+		{
+			modelTime4dot12 = 0;
+			modelTime8dot8 = 0;
+			memset(holdingIcicles, 0, sizeof(holdingIcicles));
+			memset(drippingIcicles, 0, sizeof(drippingIcicles));
+			memset(eventSlotHead, 0xFF, sizeof(eventSlotHead));
+		}
+
 		void
 		SetInitialState(
+			int				inIcicle,
 			CModule_Icicle*	inParent)
 		{
-			SetNewState(inParent);
-			SetNextDripTime(inParent);
-			curDepth4dot12 = (uint16_t)GetRandomFloat(1.0f, maxDepth4dot12);
-			if(GetRandomInt(0, 2) == 0)
+			SetNewState(inIcicle, inParent);
+			SetNextDripTime(inIcicle, inParent);
+			curDepth4dot12[inIcicle] = (int16_t)inParent->RandomRange(1, maxDepth4dot12[inIcicle]);
+			if(inParent->RandomNext() & 0x80000000)
 			{
-				growthRateLEDsPerSec4dot12 = -growthRateLEDsPerSec4dot12;
+				growthRateLEDsPerSec4dot12[inIcicle] = -growthRateLEDsPerSec4dot12[inIcicle];
 			}
 		}
 
+		// Advance the model clock and step every icicle that has something going on, ioDirtyIcicles gets the bit of each icicle
+		//	that renders differently afterward. The results are the same as counting down the hold and drip times of every
+		//	icicle on every tick.
 		void
-		UpdateIcicleState(
+		UpdateIcicleStates(
 			int16_t			inUpdateSecs4dot12,
+			uint32_t*		ioDirtyIcicles,
 			CModule_Icicle*	inParent)
 		{
-			if(curMaxDepthLifeTime4dot12 > 0)
+			uint32_t	prevModelTime4dot12 = modelTime4dot12;
+			uint32_t	prevModelTime8dot8 = modelTime8dot8;
+
+			modelTime4dot12 += inUpdateSecs4dot12;
+			modelTime8dot8 += inUpdateSecs4dot12 >> 4;
+
+			StepMovingIcicles(inUpdateSecs4dot12, ioDirtyIcicles, inParent);
+
+			// The hold color fades from the grow down to the recede up color as the hold goes on
+			for(int i = 0; i < eBitWords; ++i)
 			{
-				if(curMaxDepthLifeTime4dot12 + inUpdateSecs4dot12 < maxDepthLifeTime4dot12)
+				for(uint32_t bits = holdingIcicles[i] & ~drippingIcicles[i]; bits != 0; bits &= bits - 1)
 				{
-					curMaxDepthLifeTime4dot12 += inUpdateSecs4dot12;
+					int	icicle = i * 32 + __builtin_ctz(bits);
+
+					if(GetHoldTransition8dot8(icicle, prevModelTime4dot12) != GetHoldTransition8dot8(icicle, modelTime4dot12))
+					{
+						ioDirtyIcicles[i] |= 1UL << (icicle & 31);
+					}
 				}
+			}
 
-				// We are done staying at the max depth so start receding
-				else
+			ProcessEvents(prevModelTime4dot12, prevModelTime8dot8, ioDirtyIcicles);
+		}
+
+		void
+		StepMovingIcicles(
+			int16_t			inUpdateSecs4dot12,
+			uint32_t*		ioDirtyIcicles,
+			CModule_Icicle*	inParent)
+		{
+			// Icicles that are only growing or receding and don't reach the end of their range are stepped several at a time,
+			//	the rest are handed to UpdateIcicleState() so the result is the same as stepping them one by one. The icicles
+			//	past the last whole group are stepped one by one, that count is known at compile time and usually 0
+#if ICICLE_SIMD && defined(__SSE2__)
+			enum { eGroupEnd = eIcicleTotal & ~7 };
+
+			__m128i const	zero = _mm_setzero_si128();
+			__m128i const	minusOne = _mm_set1_epi16(-1);
+			__m128i const	laneBits = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+			__m128i const	updateSecs4dot12 = _mm_set1_epi16(inUpdateSecs4dot12);
+
+			for(int i = 0; i < eGroupEnd; i += 8)
+			{
+				uint32_t	holdingMask = (holdingIcicles[i >> 5] >> (i & 31)) & 0xFF;
+				uint32_t	drippingMask = (drippingIcicles[i >> 5] >> (i & 31)) & 0xFF;
+				uint32_t	movingMask = (~holdingMask | drippingMask) & 0xFF;
+
+				if(movingMask == 0)
 				{
-					growthRateLEDsPerSec4dot12 = -growthRateLEDsPerSec4dot12;
-					curMaxDepthLifeTime4dot12 = 0;
+					continue;
 				}
+
+				__m128i	curDepth = _mm_load_si128((__m128i const*)(curDepth4dot12 + i));
+				__m128i	growthRate = _mm_load_si128((__m128i const*)(growthRateLEDsPerSec4dot12 + i));
+				__m128i	maxDepth = _mm_load_si128((__m128i const*)(maxDepth4dot12 + i));
+
+				// The low 16 bits of (growthRate * updateSecs) >> 12
+				__m128i	depthStep = _mm_or_si128(_mm_srli_epi16(_mm_mullo_epi16(growthRate, updateSecs4dot12), 12), _mm_slli_epi16(_mm_mulhi_epi16(growthRate, updateSecs4dot12), 4));
+				__m128i	newDepth = _mm_add_epi16(curDepth, depthStep);
+				__m128i	receding = _mm_cmplt_epi16(growthRate, zero);
+				__m128i	depthInRange = _mm_or_si128(_mm_and_si128(receding, _mm_cmpgt_epi16(newDepth, minusOne)), _mm_andnot_si128(receding, _mm_cmplt_epi16(newDepth, maxDepth)));
+				__m128i	busy = _mm_and_si128(_mm_set1_epi16(int16_t(holdingMask | drippingMask)), laneBits);
+				__m128i	simple = _mm_and_si128(depthInRange, _mm_cmpeq_epi16(busy, zero));
+				__m128i	sameDepth = _mm_cmpeq_epi16(_mm_srai_epi16(newDepth, 4), _mm_srai_epi16(curDepth, 4));
+
+				_mm_store_si128((__m128i*)(curDepth4dot12 + i), _mm_or_si128(_mm_and_si128(simple, newDepth), _mm_andnot_si128(simple, curDepth)));
+
+				uint32_t	simpleMask = _mm_movemask_epi8(_mm_packs_epi16(simple, zero));
+				uint32_t	dirtyMask = _mm_movemask_epi8(_mm_packs_epi16(_mm_andnot_si128(sameDepth, simple), zero));
+
+				UpdateIcicleGroup(i, movingMask & ~simpleMask, dirtyMask, inUpdateSecs4dot12, ioDirtyIcicles, inParent);
 			}
-			else
+#elif ICICLE_SIMD && defined(__ARM_ARCH_7EM__)
+			enum { eGroupEnd = eIcicleTotal & ~1 };
+
+			for(int i = 0; i < eGroupEnd; i += 2)
+			{
+				uint32_t	holdingMask = (holdingIcicles[i >> 5] >> (i & 31)) & 0x3;
+				uint32_t	drippingMask = (drippingIcicles[i >> 5] >> (i & 31)) & 0x3;
+				uint32_t	movingMask = (~holdingMask | drippingMask) & 0x3;
+
+				if(movingMask == 0)
+				{
+					continue;
+				}
+
+				uint32_t	curDepth = *(uint32_t const*)(curDepth4dot12 + i);
+				uint32_t	growthRate = *(uint32_t const*)(growthRateLEDsPerSec4dot12 + i);
+
+				// The compiler turns these into smulbb and smultb
+				int32_t		depthStepLo = (int32_t(int16_t(growthRate)) * inUpdateSecs4dot12) >> 12;
+				int32_t		depthStepHi = (int32_t(growthRate) >> 16) * inUpdateSecs4dot12 >> 12;
+				uint32_t	newDepth = DSP_UAdd16(curDepth, (uint32_t(depthStepLo) & 0xFFFF) | (uint32_t(depthStepHi) << 16));
+
+				uint32_t	busyMask = holdingMask | drippingMask;
+				uint32_t	notBusy = ((busyMask & 1) ? 0 : 0xFFFF) | ((busyMask & 2) ? 0 : 0xFFFF0000);
+				uint32_t	receding = ((growthRate >> 15) & 0x10001) * 0xFFFF;
+				uint32_t	negative = ((newDepth >> 15) & 0x10001) * 0xFFFF;
+				uint32_t	atMaxDepth = DSP_SGEMask16(newDepth, *(uint32_t const*)(maxDepth4dot12 + i));
+				uint32_t	simple = ~((receding & negative) | (~receding & atMaxDepth)) & notBusy;
+
+				*(uint32_t*)(curDepth4dot12 + i) = (newDepth & simple) | (curDepth & ~simple);
+
+				uint32_t	moved = (newDepth ^ curDepth) & 0xFFF0FFF0 & simple;
+				uint32_t	simpleMask = (simple & 1) | ((simple >> 15) & 2);
+				uint32_t	dirtyMask = ((moved & 0xFFFF) != 0 ? 1 : 0) | ((moved >> 16) != 0 ? 2 : 0);
+
+				UpdateIcicleGroup(i, movingMask & ~simpleMask, dirtyMask, inUpdateSecs4dot12, ioDirtyIcicles, inParent);
+			}
+#else
+			enum { eGroupEnd = 0 };
+#endif
+
+			for(int i = eGroupEnd; i < eIcicleTotal; ++i)
+			{
+				if(IsHolding(i) && !IsDripping(i))
+				{
+					continue;
+				}
+
+				if(UpdateIcicleState(i, inUpdateSecs4dot12, inParent))
+				{
+					ioDirtyIcicles[i >> 5] |= 1UL << (i & 31);
+				}
+			}
+		}
+
+		// inFirst is a multiple of the vector width so a whole group lands in one word of ioDirtyIcicles
+		void
+		UpdateIcicleGroup(
+			int				inFirst,
+			uint32_t		inComplexMask,
+			uint32_t		inDirtyMask,
+			int16_t			inUpdateSecs4dot12,
+			uint32_t*		ioDirtyIcicles,
+			CModule_Icicle*	inParent)
+		{
+			for(; inComplexMask != 0; inComplexMask &= inComplexMask - 1)
+			{
+				int	lane = __builtin_ctz(inComplexMask);
+
+				if(UpdateIcicleState(inFirst + lane, inUpdateSecs4dot12, inParent))
+				{
+					inDirtyMask |= 1UL << lane;
+				}
+			}
+
+			ioDirtyIcicles[inFirst >> 5] |= inDirtyMask << (inFirst & 31);
+		}
+
+		// Step one icicle that is growing, receding or dripping, the model clock has already been advanced.
+		//	Returns true if the icicle will render differently than before the update
+		bool
+		UpdateIcicleState(
+			int				inIcicle,
+			int16_t			inUpdateSecs4dot12,
+			CModule_Icicle*	inParent)
+		{
+			uint32_t	prevRenderKey = GetRenderKey(inIcicle, modelTime4dot12 - inUpdateSecs4dot12);
+
+			// A holding icicle stays put until its hold end event
+			if(!IsHolding(inIcicle))
 			{
-				curDepth4dot12 += uint16_t((int32_t(growthRateLEDsPerSec4dot12) * int32_t(inUpdateSecs4dot12)) >> 12);
+				curDepth4dot12[inIcicle] += uint16_t((int32_t(growthRateLEDsPerSec4dot12[inIcicle]) * int32_t(inUpdateSecs4dot12)) >> 12);
 
-				if(!(growthRateLEDsPerSec4dot12 & 0x8000))
+				if(!(growthRateLEDsPerSec4dot12[inIcicle] & 0x8000))
 				{
-					if(curDepth4dot12 >= maxDepth4dot12)
+					if(curDepth4dot12[inIcicle] >= maxDepth4dot12[inIcicle])
 					{
-						curMaxDepthLifeTime4dot12 = 1;
-						curDepth4dot12 = maxDepth4dot12;
+						// Hold at the max depth, the hold ends on the first tick at least maxDepthLifeTime - 1 after this one
+						curDepth4dot12[inIcicle] = maxDepth4dot12[inIcicle];
+						SetHoldStartTime4dot12(inIcicle, modelTime4dot12);
+						holdingIcicles[inIcicle >> 5] |= 1UL << (inIcicle & 31);
+						ScheduleEvent(eEventNode_HoldEnd + inIcicle, modelTime4dot12 + maxDepthLifeTime4dot12[inIcicle] - 1);
 					}
 				}
 				else
 				{
-					if(curDepth4dot12 & 0x8000)
+					if(curDepth4dot12[inIcicle] & 0x8000)
 					{
-						SetNewState(inParent);
+						SetNewState(inIcicle, inParent);
 					}
 				}
 			}
 
 			// Check if we are dripping water
-			if(waterDripLoc4dot12 > 0)
+			if(IsDripping(inIcicle))
 			{
-				if(waterDripLoc4dot12 < curDepth4dot12)
+				if(waterDripLoc4dot12[inIcicle] < curDepth4dot12[inIcicle])
 				{
-					waterDripLoc4dot12 += uint16_t(inParent->settings.waterDripRatePreLEDsPerSec * inUpdateSecs4dot12);
+					waterDripLoc4dot12[inIcicle] += uint16_t(inParent->settings.waterDripRatePreLEDsPerSec * inUpdateSecs4dot12);
 				}
 				else
 				{
-					waterDripLoc4dot12 += uint16_t(inParent->settings.waterDripRatePostLEDsPerTick * inUpdateSecs4dot12);
+					waterDripLoc4dot12[inIcicle] += uint16_t(inParent->settings.waterDripRatePostLEDsPerTick * inUpdateSecs4dot12);
 				}
 
-				if((waterDripLoc4dot12 >> 12) >= eLEDsPerIcicle)
+				if((waterDripLoc4dot12[inIcicle] >> 12) >= eLEDsPerIcicle)
 				{
 					// time to reset
-					SetNextDripTime(inParent);
+					SetNextDripTime(inIcicle, inParent);
+				}
+				else if(waterDripLoc4dot12[inIcicle] <= 0)
+				{
+					// A negative drip rate pushed the drop back out of the icicle, finish the countdown it started from
+					drippingIcicles[inIcicle >> 5] &= ~(1UL << (inIcicle & 31));
+					SetDripStartTime8dot8(inIcicle, GetDripCountdown8dot8(inIcicle) + modelTime8dot8);
+					ScheduleDripStart(inIcicle);
 				}
 			}
 
-			// We are not dripping water, deduct from the next time a water drip should start
-			else if((inUpdateSecs4dot12 >> 4) <= nextDripTime8dot8)
+			return GetRenderKey(inIcicle, modelTime4dot12) != prevRenderKey;
+		}
+
+		// Handle every event that came due since the previous tick
+		void
+		ProcessEvents(
+			uint32_t	inPrevModelTime4dot12,
+			uint32_t	inPrevModelTime8dot8,
+			uint32_t*	ioDirtyIcicles)
+		{
+			uint32_t	firstSlot = inPrevModelTime4dot12 >> eWheelSlotShift;
+			uint32_t	lastSlot = modelTime4dot12 >> eWheelSlotShift;
+
+			if(lastSlot - firstSlot >= eWheelSlotCount)
 			{
-				nextDripTime8dot8 -= (inUpdateSecs4dot12 >> 4);
+				// The wheel went all the way around so every slot has to be looked at once
+				firstSlot = lastSlot - eWheelSlotCount + 1;
 			}
 
-			// time to start a water drop
-			else
+			for(uint32_t slot = firstSlot; slot != lastSlot + 1; ++slot)
+			{
+				// Take the whole list off the slot so events that aren't due yet can be put back while walking it
+				uint16_t	node = eventSlotHead[slot & (eWheelSlotCount - 1)];
+
+				eventSlotHead[slot & (eWheelSlotCount - 1)] = eEventNode_None;
+
+				while(node != eEventNode_None)
+				{
+					uint16_t	nextNode = eventNext[node];
+
+					if(node < eEventNode_DripStart)
+					{
+						int	icicle = node - eEventNode_HoldEnd;
+
+						uint32_t	heldFor4dot12 = GetHoldElapsed4dot12(icicle, modelTime4dot12);
+
+						if(heldFor4dot12 < uint32_t(maxDepthLifeTime4dot12[icicle] - 1))
+						{
+							ScheduleEvent(node, modelTime4dot12 - heldFor4dot12 + maxDepthLifeTime4dot12[icicle] - 1);
+						}
+						else
+						{
+							// We are done staying at the max depth so start receding
+							growthRateLEDsPerSec4dot12[icicle] = -growthRateLEDsPerSec4dot12[icicle];
+							holdingIcicles[icicle >> 5] &= ~(1UL << (icicle & 31));
+							ioDirtyIcicles[icicle >> 5] |= 1UL << (icicle & 31);
+						}
+					}
+					else
+					{
+						int	icicle = node - eEventNode_DripStart;
+
+						if(int32_t(modelTime8dot8 - GetDripStartTime8dot8(icicle)) <= 0)
+						{
+							// The slot is only a guess for drips so move it to a better one
+							ScheduleDripStart(icicle);
+						}
+						else
+						{
+							// start a drip
+							SetDripStartTime8dot8(icicle, GetDripStartTime8dot8(icicle) - inPrevModelTime8dot8);
+							waterDripLoc4dot12[icicle] = 1;
+							drippingIcicles[icicle >> 5] |= 1UL << (icicle & 31);
+						}
+					}
+
+					node = nextNode;
+				}
+			}
+		}
+
+		uint8_t
+		ScheduleEvent(
+			uint16_t	inNode,
+			uint32_t	inModelTime4dot12)
+		{
+			uint8_t		slot = uint8_t((inModelTime4dot12 >> eWheelSlotShift) & (eWheelSlotCount - 1));
+			uint16_t*	head = &eventSlotHead[slot];
+
+			eventNext[inNode] = *head;
+			*head = inNode;
+
+			return slot;
+		}
+
+		void
+		ScheduleDripStart(
+			int	inIcicle)
+		{
+			// The 8.8 clock drops the low 4 bits of every tick so it can't reach the start time any sooner than this
+			uint8_t	slot = ScheduleEvent(eEventNode_DripStart + inIcicle, modelTime4dot12 + ((GetDripStartTime8dot8(inIcicle) - modelTime8dot8 + 1) << 4));
+
+			SetDripStartSlot(inIcicle, slot);
+		}
+
+		// Take the drip start of an icicle that isn't dripping back off the wheel
+		void
+		UnscheduleDripStart(
+			int	inIcicle)
+		{
+			uint16_t	node = uint16_t(eEventNode_DripStart + inIcicle);
+			uint16_t*	link = &eventSlotHead[GetDripStartSlot(inIcicle)];
+
+			while(*link != node)
 			{
-				// start a drip
-				waterDripLoc4dot12 = 1;
+				MAssert(*link != eEventNode_None);
+				link = &eventNext[*link];
 			}
+
+			*link = eventNext[node];
 		}
 
+		// Resample the parameters drawn from the tables in inTables without moving the icicle. A holding icicle keeps its
+		//	max depth and hold time and a dripping one keeps its drip, they pick those up from SetNewState() and
+		//	SetNextDripTime() later
 		void
-		SetNewState(
+		ReseedIcicle(
+			int				inIcicle,
+			uint8_t			inTables,
 			CModule_Icicle*	inParent)
 		{
-			curDepth4dot12 = 0;
-			maxDepth4dot12 = uint16_t(GetRandomFloat(1.0f, eLEDsPerIcicle) * float(1 << 12));
+			bool	holding = IsHolding(inIcicle);
 
-			growthRateLEDsPerSec4dot12 = (uint16_t)(GetRandomFloatGuassian(inParent->settings.meanGrowRateLEDsPerSec, inParent->settings.stdGrowRateLEDsPerSec) * float(1 << 12));
-			if(growthRateLEDsPerSec4dot12 < 1)
+			if(inTables & eGaussianTable_GrowRate)
 			{
-				growthRateLEDsPerSec4dot12 = 1;
+				int16_t	growthRate = (int16_t)inParent->growRateTable.Sample(inParent->RandomNext());
+
+				growthRateLEDsPerSec4dot12[inIcicle] = (growthRateLEDsPerSec4dot12[inIcicle] & 0x8000) ? int16_t(-growthRate) : growthRate;
 			}
-			else if(growthRateLEDsPerSec4dot12 > 0x1000)
+
+			if((inTables & eGaussianTable_PeekDepth) && !holding)
 			{
-				growthRateLEDsPerSec4dot12 = 0x1000;
+				maxDepth4dot12[inIcicle] = (int16_t)inParent->peekDepthTable.Sample(inParent->RandomNext());
 			}
-			//growthRateLEDsPerSec4dot12 = -growthRateLEDsPerSec4dot12;
 
-			maxDepth4dot12 = (uint16_t)(GetRandomFloatGuassian(inParent->settings.meanPeekDepth, inParent->settings.stdPeekDepth) * float(1 << 12));
-			if(maxDepth4dot12 < 0x17FF)
+			if((inTables & eGaussianTable_PeekDepthLifetime) && !holding)
 			{
-				maxDepth4dot12 = 0x17FF;
+				maxDepthLifeTime4dot12[inIcicle] = inParent->peekDepthLifetimeTable.Sample(inParent->RandomNext());
 			}
-			else if(maxDepth4dot12 > eLEDsPerIcicle << 12)
+
+			if((inTables & eGaussianTable_DripStartTime) && !IsDripping(inIcicle))
 			{
-				maxDepth4dot12 = eLEDsPerIcicle << 12;
+				UnscheduleDripStart(inIcicle);
+				SetDripStartTime8dot8(inIcicle, modelTime8dot8 + inParent->dripStartTimeTable.Sample(inParent->RandomNext()));
+				ScheduleDripStart(inIcicle);
 			}
+		}
+
+		inline bool
+		IsHolding(
+			int	inIcicle) const
+		{
+			return (holdingIcicles[inIcicle >> 5] & (1UL << (inIcicle & 31))) != 0;
+		}
+
+		inline bool
+		IsDripping(
+			int	inIcicle) const
+		{
+			return (drippingIcicles[inIcicle >> 5] & (1UL << (inIcicle & 31))) != 0;
+		}
+
+#if ICICLE_PACKED_ICICLES
+		// Only the low 16 bits of the hold start are kept, a hold never runs more than the longest lifetime plus a tick so
+		//	this is exact for any time from the start of the hold to its end event
+		inline uint32_t
+		GetHoldElapsed4dot12(
+			int			inIcicle,
+			uint32_t	inModelTime4dot12) const
+		{
+			return uint16_t(uint16_t(inModelTime4dot12) - holdStartTime4dot12[inIcicle]);
+		}
+
+		inline void
+		SetHoldStartTime4dot12(
+			int			inIcicle,
+			uint32_t	inTime4dot12)
+		{
+			holdStartTime4dot12[inIcicle] = uint16_t(inTime4dot12);
+		}
+
+		// The drip start keeps 24 bits, a pending start is never more than a table sample ahead or a tick behind the model
+		//	clock so the rest of it comes back from modelTime8dot8
+		inline uint32_t
+		GetDripStartTime8dot8(
+			int	inIcicle) const
+		{
+			return modelTime8dot8 + uint32_t(int32_t(((dripStartAndSlot[inIcicle] >> 8) - modelTime8dot8) << 8) >> 8);
+		}
+
+		// While dripping the same bits hold the countdown that was left when the drip started
+		inline uint32_t
+		GetDripCountdown8dot8(
+			int	inIcicle) const
+		{
+			return uint32_t(int32_t(dripStartAndSlot[inIcicle]) >> 8);
+		}
+
+		inline void
+		SetDripStartTime8dot8(
+			int			inIcicle,
+			uint32_t	inTime8dot8)
+		{
+			dripStartAndSlot[inIcicle] = (inTime8dot8 << 8) | (dripStartAndSlot[inIcicle] & 0xFF);
+		}
+
+		inline uint8_t
+		GetDripStartSlot(
+			int	inIcicle) const
+		{
+			return uint8_t(dripStartAndSlot[inIcicle]);
+		}
+
+		inline void
+		SetDripStartSlot(
+			int		inIcicle,
+			uint8_t	inSlot)
+		{
+			dripStartAndSlot[inIcicle] = (dripStartAndSlot[inIcicle] & ~0xFFUL) | inSlot;
+		}
+#else
+		inline uint32_t
+		GetHoldElapsed4dot12(
+			int			inIcicle,
+			uint32_t	inModelTime4dot12) const
+		{
+			return inModelTime4dot12 - holdStartTime4dot12[inIcicle];
+		}
+
+		inline void
+		SetHoldStartTime4dot12(
+			int			inIcicle,
+			uint32_t	inTime4dot12)
+		{
+			holdStartTime4dot12[inIcicle] = inTime4dot12;
+		}
+
+		inline uint32_t
+		GetDripStartTime8dot8(
+			int	inIcicle) const
+		{
+			return dripStartTime8dot8[inIcicle];
+		}
+
+		inline uint32_t
+		GetDripCountdown8dot8(
+			int	inIcicle) const
+		{
+			return dripStartTime8dot8[inIcicle];
+		}
+
+		inline void
+		SetDripStartTime8dot8(
+			int			inIcicle,
+			uint32_t	inTime8dot8)
+		{
+			dripStartTime8dot8[inIcicle] = inTime8dot8;
+		}
+
+		inline uint8_t
+		GetDripStartSlot(
+			int	inIcicle) const
+		{
+			return dripStartSlot[inIcicle];
+		}
+
+		inline void
+		SetDripStartSlot(
+			int		inIcicle,
+			uint8_t	inSlot)
+		{
+			dripStartSlot[inIcicle] = inSlot;
+		}
+#endif
 
-			maxDepthLifeTime4dot12 = (uint16_t)(GetRandomFloatGuassian(inParent->settings.meanPeekDepthLifetimeSec, inParent->settings.stdPeekDepthLifetimeSec) * float(1 << 12));
-			if(maxDepthLifeTime4dot12 < 0x1000)
+		// How far the hold color has faded toward the recede up color at the given model time
+		inline uint32_t
+		GetHoldTransition8dot8(
+			int			inIcicle,
+			uint32_t	inModelTime4dot12) const
+		{
+			return ((GetHoldElapsed4dot12(inIcicle, inModelTime4dot12) + 1) << 8) / uint32_t(maxDepthLifeTime4dot12[inIcicle]);
+		}
+
+		// This packs everything RenderDynamicIcicle() reads at the precision it reads it
+		uint32_t
+		GetRenderKey(
+			int			inIcicle,
+			uint32_t	inModelTime4dot12) const
+		{
+			uint32_t	colorKey;
+
+			if(IsHolding(inIcicle))
+			{
+				colorKey = GetHoldTransition8dot8(inIcicle, inModelTime4dot12);
+			}
+			else if(growthRateLEDsPerSec4dot12[inIcicle] & 0x8000)
 			{
-				maxDepthLifeTime4dot12 = 0x1000;
+				colorKey = 0x100;
 			}
-			else if(maxDepthLifeTime4dot12 > 0x7000)
+			else
 			{
-				maxDepthLifeTime4dot12 = 0x7000;
+				// Growing down renders the same as the start of the max depth transition
+				colorKey = 0;
 			}
 
-			curMaxDepthLifeTime4dot12 = 0;
+			// 11 bits of depth and drip location in 4.8 covers eLEDsPerIcicle up to 7
+			return (uint32_t(curDepth4dot12[inIcicle] >> 4) & 0x7FF) | ((uint32_t(waterDripLoc4dot12[inIcicle] >> 4) & 0x7FF) << 11) | (colorKey << 22);
+		}
+
+		void
+		SetNewState(
+			int				inIcicle,
+			CModule_Icicle*	inParent)
+		{
+			// The tables are already clamped to the ranges each field allows
+			curDepth4dot12[inIcicle] = 0;
+			growthRateLEDsPerSec4dot12[inIcicle] = (int16_t)inParent->growRateTable.Sample(inParent->RandomNext());
+			maxDepth4dot12[inIcicle] = (int16_t)inParent->peekDepthTable.Sample(inParent->RandomNext());
+			maxDepthLifeTime4dot12[inIcicle] = inParent->peekDepthLifetimeTable.Sample(inParent->RandomNext());
+			holdingIcicles[inIcicle >> 5] &= ~(1UL << (inIcicle & 31));
 		}
 
 		void
 		SetNextDripTime(
+			int				inIcicle,
 			CModule_Icicle*	inParent)
 		{
-			waterDripLoc4dot12 = 0;
-			nextDripTime8dot8 = (uint16_t)(GetRandomFloatGuassian(inParent->settings.meanIcicleStartDripTime, inParent->settings.stdIcicleStartDripTime) * float(1 << 8));
+			waterDripLoc4dot12[inIcicle] = 0;
+			drippingIcicles[inIcicle >> 5] &= ~(1UL << (inIcicle & 31));
+			SetDripStartTime8dot8(inIcicle, modelTime8dot8 + inParent->dripStartTimeTable.Sample(inParent->RandomNext()));
+			ScheduleDripStart(inIcicle);
 		}
 
 		// This is the current depth in fractional LEDs, 0 is at the top and eLEDsPerIcicle is at the bottom
-		int16_t	curDepth4dot12;
+		int16_t	curDepth4dot12[eLaneTotal];
 
 		// The grow rate in fractional LEDs
-		int16_t	growthRateLEDsPerSec4dot12;
+		int16_t	growthRateLEDsPerSec4dot12[eLaneTotal];
 
 		// The max depth of this icicle before it starts to recede
-		int16_t	maxDepth4dot12;
+		int16_t	maxDepth4dot12[eLaneTotal];
 
 		// The current water drip location in fractional LEDs
-		int16_t	waterDripLoc4dot12;
+		int16_t	waterDripLoc4dot12[eLaneTotal];
+
+		// The lifetime of the icicle at the maximum depth in secs
+		uint16_t	maxDepthLifeTime4dot12[eLaneTotal];
+
+#if ICICLE_PACKED_ICICLES
+		// The low 16 bits of the model time when the icicle reached its maximum depth, see GetHoldElapsed4dot12()
+		uint16_t	holdStartTime4dot12[eLaneTotal];
+
+		// The top 24 bits are the drip start time, the drip starts on the first tick that modelTime8dot8 is past it and
+		//	while dripping they hold what was left of the countdown when the drip started. The low 8 bits are the wheel slot
+		//	of the drip start so it can be taken back off
+		uint32_t	dripStartAndSlot[eLaneTotal];
+#else
+		uint32_t	holdStartTime4dot12[eLaneTotal];
+		uint32_t	dripStartTime8dot8[eLaneTotal];
+		uint8_t		dripStartSlot[eLaneTotal];
+#endif
 
-		// The lifetime of the icicle at the maximum depth in ticks
-		uint16_t	maxDepthLifeTime4dot12;
+		// The sum of the tick times, and the sum of the tick times in 8.8 which drops the low bits of every tick
+		uint32_t	modelTime4dot12;
+		uint32_t	modelTime8dot8;
 
-		// The current lifetime remaining at the maximum depth in ticks
-		uint16_t	curMaxDepthLifeTime4dot12;
+		uint32_t	holdingIcicles[eBitWords];
+		uint32_t	drippingIcicles[eBitWords];
 
-		// The next water drip time in MS
-		uint16_t	nextDripTime8dot8;
+		// The timing wheel, each slot is a list of event nodes linked through eventNext
+		uint16_t	eventSlotHead[eWheelSlotCount];
+		uint16_t	eventNext[eEventNode_Count];
 	};
 
 	OctoWS2811		leds;
-	SIcicleState	icicles[eIcicleTotal];
+	SIcicleStates	icicles;
 	SSettings		settings;
 
+	// One table per gaussian distribution in settings, rebuilt when the distribution is set
+	SGaussianTable	growRateTable;
+	SGaussianTable	peekDepthTable;
+	SGaussianTable	peekDepthLifetimeTable;
+	SGaussianTable	dripStartTimeTable;
+
+	uint32_t		randomSeed;
+	uint32_t		randomState;
+
+	// The tables lazy apply is resampling and how many icicles are left, starting from reseedCursor
+	uint8_t			reseedTables;
+	uint16_t		reseedRemaining;
+	uint16_t		reseedCursor;
+
+	// Built from the settings colors by DynamicPalette_Build(), indexed by the 8.8 transition or coverage up to 0x100
+	uint16_t		icePalette8dot8[0x101][3];
+	uint16_t		dripPalette8dot8[0x101][3];
+
+	// FrameTranspose() passes every channel byte through outputLUT, the gamma curve scaled by the mode brightness. The
+	//	lookups are skipped when it wouldn't change anything
+	uint8_t			gammaLUT[3][256];
+	uint8_t			outputLUT[3][256];
+	bool			gammaLUTIdentity;
+	bool			outputLUTIdentity;
+
+	// SettingsSave() marks the settings dirty, they are copied to settingsFlushImage and written to the next slot after
+	//	the quiet period
+	bool			settingsDirty;
+	bool			settingsFlushing;
+	uint32_t		settingsChangedUS;
+	uint8_t			settingsSlot;
+	uint8_t			settingsFlushSlot;
+	uint16_t		settingsFlushOffset;
+	uint32_t		settingsSequence;
+	uint32_t		settingsSaveCount;
+	uint32_t		settingsFlushCount;
+	uint32_t		settingsBytesWritten;
+	uint8_t			settingsFlushImage[sizeof(SSettingsSlotHeader) + sizeof(SSettings)];
+
+	// The settings part of the home page as last sent, gHomePageCache holds homePageLength bytes of it when valid
+	bool			homePageValid;
+	uint16_t		homePageLength;
+
 	uint32_t		updateCumulatorUS;
 
-	uint16_t	icicleIndex;
-	uint8_t		renderOrStateUpdate;
-	uint8_t		testMode;
+	// One bit per icicle that needs to be redrawn by RenderDynamicIceDirty()
+	uint32_t		dirtyIcicles[(eIcicleTotal + 31) / 32];
+	uint32_t		dirtyIcicleCount;
+	uint32_t		dirtyFrameCount;
+	uint32_t		skippedShowCount;
+
+	// The render mode that is in the display memory, 0xFF when nothing has been rendered yet
+	uint8_t		renderedMode;
+
+	// Set when the whole frame needs to be redrawn instead of just the dirty icicles, the modes other than dynamic ice
+	//	don't draw at all until it is set
+	bool		frameInvalid;
+
+	// Set when gIcicleLEDDrawMemory holds a frame that FramePresent() has not sent yet
+	bool		frameReady;
+	uint32_t	framesSentCount;
+	uint32_t	dmaWaitCount;
+	uint32_t	dmaWaitTotalUS;
+	uint32_t	dmaWaitMaxUS;
+
+	// Frames are started by Update() once frameElapsedUS reaches frameIntervalUS
+	uint32_t	frameDMAWaitUS;
+	uint32_t	frameElapsedUS;
+	uint32_t	frameIntervalUS;
+	uint32_t	framesRunCount;
+	uint32_t	missedDeadlineCount;
+	uint32_t	coalescedFrameCount;
+	uint32_t	frameCostAvgUS;
+	uint32_t	frameCostMaxUS;
+	uint32_t	pacingStatsStartUS;
+	uint32_t	frameLastStartUS;
+	uint32_t	frameIntervalMaxUS;
+
+	// When the last Update() or WebSlice_Yield() ran, and how much of the next delta the yields since then covered
+	uint32_t	lastUpdateUS;
+	uint32_t	webYieldedUS;
+	uint32_t	webYieldCount;
+
+	// Set from the first stream packet until the stream times out. Once an ArtSync has come frames wait for the next
+	//	one, until then a frame is complete when every bit of streamUniverseMask is set
+	bool		streamActive;
+	bool		streamSyncSeen;
+	bool		streamFrameReady;
+	uint32_t	streamUniverseMask;
+	uint32_t	streamLastPacketUS;
+	uint32_t	streamFrameCompleteUS;
+	uint32_t	streamPacketCount;
+	uint32_t	streamBadPacketCount;
+	uint32_t	streamOverrunCount;
+	uint32_t	streamFrameCount;
+	uint32_t	streamStartCount;
+	uint32_t	streamTimeoutCount;
+	uint32_t	streamLatencyTotalUS;
+	uint32_t	streamLatencyMaxUS;
+	uint32_t	streamStatsStartUS;
+
+	// Recording and playback share the chunk, it buffers appends while recording and reads otherwise. A forced keyframe
+	//	follows anything that shows a frame the recording didn't see
+	bool		showRecording;
+	bool		showRecordFull;
+	bool		showRecordKeyNext;
+	uint32_t	showRecordRemaining;
+	uint32_t	showRecordFrame;
+	uint32_t	showRecordDelayUS;
+	uint32_t	showRecordBytes;
+	uint8_t		showChunk[eShowChunkSize];
+	uint32_t	showChunkStart;
+	uint16_t	showChunkLength;
+	uint8_t		showKeyframeInterval;
+
+	// The playback reads the header of the next record ahead so it knows when that frame is due
+	bool		showOpen;
+	bool		showChecked;
+	bool		showScanning;
+	uint32_t	showScanOffset;
+	uint32_t	showFrameCount;
+	uint32_t	showKeyframeOffset[eShowKeyframeIndexMax];
+	uint16_t	showKeyframeCount;
+	uint32_t	showReadOffset;
+	uint32_t	showPlayFrame;
+	uint8_t		showPlayTag;
+	uint32_t	showPlayDelayUS;
+	uint32_t	showPlayBytes;
+	uint32_t	showPlayElapsedUS;
+
+	// Node 0 sends a sync ahead of every frame and each node presents it at canPresentAtUS by its own clock. Followers
+	//	pace themselves until the first sync and again once they stop coming
+	bool			canSynced;
+	bool			canPresentPending;
+	uint8_t			canSyncSequence;
+	uint32_t		canPresentAtUS;
+	uint32_t		canPresentDeltaUS;
+	uint32_t		canMasterPresentUS;
+	uint32_t		canLastSyncUS;
+	SCANClockSync	canClockSync;
+	uint32_t		canSyncSentCount;
+	uint32_t		canSyncReceivedCount;
+	uint32_t		canSyncMissedCount;
+	uint32_t		canLateCount;
+	uint32_t		canFallbackCount;
+	uint32_t		canPresentErrorMaxUS;
+	uint32_t		canWriteFailCount;
+	uint32_t		canBadFrameCount;
+	uint32_t		canBitsSent;
+	uint32_t		canBitsReceived;
+	uint32_t		canStatsStartUS;
+
+	// SettingsSave() marks the settings to go out to the other nodes, canSettingsChunk is how far the send has got
+	bool					canSettingsPending;
+	bool					canSettingsFromBus;
+	uint8_t					canSettingsChunk;
+	uint8_t					canSettingsImage[sizeof(SSettingsSlotHeader) + sizeof(SSettings)];
+	uint8_t					canSettingsReceiveImage[sizeof(SSettingsSlotHeader) + sizeof(SSettings)];
+	SCANSettingsAssembly	canSettingsAssembly;
+	uint32_t				canSettingsSentCount;
+	uint32_t				canSettingsAppliedCount;
+
+#if ICICLE_PERF_STATS
+	SPerfHistogram	perfStats[ePerfPhase_Count];
+#endif
 
 	bool	ledsOn;
 };
 
+// A geometry whose buffers leave less than eBoardRAMReserveBytes of the board fails here rather than when the stack runs
+//	into the heap
+static_assert(ICICLE_BOARD_RAM_BYTES == 0 || CModule_Icicle::StaticBytes() + eBoardRAMReserveBytes <= ICICLE_BOARD_RAM_BYTES, "the icicle buffers don't fit the board, use a smaller geometry or set ICICLE_DRAW_BUFFER to 0");
+
 MModuleImplementation_Start(CModule_Icicle);
 MModuleImplementation_Finish(CModule_Icicle);
 
+// Call with each UDP payload that arrives on the Art-Net port (6454)
+void
+IcicleStream_Receive(
+	uint8_t const*	inPacket,
+	uint32_t		inBytes)
+{
+	if(gIcicleModule != NULL)
+	{
+		gIcicleModule->Stream_Receive(inPacket, inBytes);
+	}
+}
+
 void
 SetupIcicleModule(
 	void)
@@ -0,0 +1,102 @@
+/*
+	Author: Brent Pease (embeddedlibraryfeedback@gmail.com)
+
+	The MIT License (MIT)
+
+	Copyright (c) 2015-FOREVER Brent Pease
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	ABOUT
+
+	The Art-Net receiver of the host build, a nonblocking UDP socket whose packets go to IcicleStream_Receive() the
+	same way the device's transport hands them over. Include it after ModuleIcicleLights.cpp
+*/
+
+#ifndef _HOSTSTREAMUDP_H_
+#define _HOSTSTREAMUDP_H_
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Returns the socket or -1, port 0 binds any free port which HostStreamUDP_Port() then reports
+inline int
+HostStreamUDP_Open(
+	uint16_t	inPort)
+{
+	int	sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+	MReturnOnError(sock < 0, -1);
+
+	sockaddr_in	addr;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(inPort);
+
+	if(bind(sock, (sockaddr*)&addr, sizeof(addr)) != 0 || fcntl(sock, F_SETFL, O_NONBLOCK) != 0)
+	{
+		close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+inline uint16_t
+HostStreamUDP_Port(
+	int	inSocket)
+{
+	sockaddr_in	addr;
+	socklen_t	addrSize = sizeof(addr);
+
+	MReturnOnError(getsockname(inSocket, (sockaddr*)&addr, &addrSize) != 0, 0);
+
+	return ntohs(addr.sin_port);
+}
+
+// Hand every packet that is waiting to the module, returns how many there were
+inline int
+HostStreamUDP_Poll(
+	int	inSocket)
+{
+	uint8_t	packet[1024];
+	int		count = 0;
+
+	for(;;)
+	{
+		ssize_t	bytes = recv(inSocket, packet, sizeof(packet), 0);
+
+		if(bytes < 0)
+		{
+			return count;
+		}
+
+		IcicleStream_Receive(packet, uint32_t(bytes));
+		++count;
+	}
+}
+
+#endif /* _HOSTSTREAMUDP_H_ */
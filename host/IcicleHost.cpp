@@ -0,0 +1,167 @@
+/*
+	Author: Brent Pease (embeddedlibraryfeedback@gmail.com)
+
+	The MIT License (MIT)
+
+	Copyright (c) 2015-FOREVER Brent Pease
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	ABOUT
+
+	Runs the icicle module on the desktop so the benches and checks that normally go through the serial console can be
+	run and repeated without a controller. Each group of arguments is one console command and groups are split by --,
+	the commands run in order on one module and the exit code is 1 if any of them fails.
+
+		icicle_host sim_verify -- render_bench 200
+		icicle_host rendermode_set allon -- tick 100 -- page /
+
+	Besides the module's own commands there are
+		tick [count] [us]: run count updates of us each, 1 of eUpdateTimeUS by default, stepping the clock with them
+		page [path]: print a page the module serves
+		stream_listen [seconds] [port]: run the module in real time for 10 seconds by default while receiving Art-Net
+			on UDP port 6454 by default, then print the stream stats
+
+		icicle_host stream_listen 60
+*/
+
+#include <time.h>
+
+#include "../ModuleIcicleLights.cpp"
+#include "HostStreamUDP.h"
+
+static bool
+HostCommand_Run(
+	CModule_Icicle*	inModule,
+	int				inArgC,
+	char const**	inArgV)
+{
+	CHostStdout	output;
+
+	if(strcmp(inArgV[0], "tick") == 0)
+	{
+		int			count = inArgC >= 2 ? atoi(inArgV[1]) : 1;
+		uint32_t	deltaUS = inArgC >= 3 ? (uint32_t)strtoul(inArgV[2], NULL, 0) : uint32_t(eUpdateTimeUS);
+
+		for(int i = 0; i < count; ++i)
+		{
+			gHostClockOffsetUS += deltaUS;
+			((CModule*)inModule)->Update(deltaUS);
+		}
+
+		return true;
+	}
+
+	if(strcmp(inArgV[0], "stream_listen") == 0)
+	{
+		int		seconds = inArgC >= 2 ? atoi(inArgV[1]) : 10;
+		int		sock = HostStreamUDP_Open(inArgC >= 3 ? (uint16_t)atoi(inArgV[2]) : 6454);
+
+		if(sock < 0)
+		{
+			fprintf(stderr, "can't listen on the port\n");
+			return false;
+		}
+
+		uint32_t	startUS = micros();
+		uint32_t	lastUS = startUS;
+		timespec	updateTime = {0, eUpdateTimeUS * 1000};
+
+		// The packets go in between updates like they do on the device, where the transport is just another module
+		while(micros() - startUS < uint32_t(seconds) * 1000000)
+		{
+			uint32_t	nowUS = micros();
+
+			HostStreamUDP_Poll(sock);
+			((CModule*)inModule)->Update(nowUS - lastUS);
+			lastUS = nowUS;
+			nanosleep(&updateTime, NULL);
+		}
+
+		close(sock);
+
+		char const*	statsArgV[] = {"stream_stats"};
+
+		return HostCommand_Run(inModule, 1, statsArgV);
+	}
+
+	if(strcmp(inArgV[0], "page") == 0)
+	{
+		char const*	path = inArgC >= 2 ? inArgV[1] : "/";
+
+		for(SHostPage const& page : gHostPages)
+		{
+			if(page.path == path)
+			{
+				page.handler(&output, inArgC - 2 > 0 ? inArgC - 2 : 0, inArgV + 2);
+				output.printf("\n");
+				return true;
+			}
+		}
+
+		fprintf(stderr, "no page %s\n", path);
+		return false;
+	}
+
+	for(SHostCommand const& command : gHostCommands)
+	{
+		if(command.name == inArgV[0])
+		{
+			return command.handler(&output, inArgC, inArgV) == eCmd_Succeeded;
+		}
+	}
+
+	fprintf(stderr, "no command %s\n", inArgV[0]);
+	return false;
+}
+
+int
+main(
+	int				inArgC,
+	char const**	inArgV)
+{
+	CModule_Icicle*	module = CModule_Icicle::Include();
+
+	((CModule*)module)->Setup();
+	((IOutdoorLightingInterface*)module)->LEDStateChange(true);
+
+	bool	failed = false;
+
+	for(int first = 1; first < inArgC;)
+	{
+		int	last = first;
+
+		while(last < inArgC && strcmp(inArgV[last], "--") != 0)
+		{
+			++last;
+		}
+
+		if(last > first && HostCommand_Run(module, last - first, inArgV + first) == false)
+		{
+			fprintf(stderr, "%s failed\n", inArgV[first]);
+			failed = true;
+		}
+
+		first = last + 1;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,734 @@
+/*
+	Author: Brent Pease (embeddedlibraryfeedback@gmail.com)
+
+	The MIT License (MIT)
+
+	Copyright (c) 2015-FOREVER Brent Pease
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	ABOUT
+
+	Host tests for the parts of the module that only show up over time or under load. Each test runs in a process of
+	its own so it starts from a freshly set up module, run them all with no arguments or name the ones to run.
+*/
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../ModuleIcicleLights.cpp"
+#include "HostStreamUDP.h"
+
+#define MTestCheck(inCondition) do { if(!(inCondition)) { fprintf(stderr, "%s:%d check failed: %s\n", __FILE__, __LINE__, #inCondition); return false; } } while(0)
+
+// A page client that takes inUSPerByte of host time for every byte it is sent
+class CHostSlowClient : public IOutputDirector
+{
+public:
+
+	CHostSlowClient(
+		uint32_t	inUSPerByte)
+	:
+		usPerByte(inUSPerByte),
+		totalBytes(0)
+	{
+	}
+
+	virtual void
+	write(
+		char const*	inMsg,
+		size_t		inBytes)
+	{
+		gHostClockOffsetUS += uint32_t(inBytes) * usPerByte;
+		totalBytes += inBytes;
+	}
+
+	uint32_t	usPerByte;
+	uint32_t	totalBytes;
+};
+
+// Keeps what a command prints so the test can read it back
+class CHostCapture : public IOutputDirector
+{
+public:
+
+	virtual void
+	write(
+		char const*	inMsg,
+		size_t		inBytes)
+	{
+		text.append(inMsg, inBytes);
+	}
+
+	std::string	text;
+};
+
+struct SIcicleHostTest
+{
+	static CModule_Icicle*
+	Module(
+		void)
+	{
+		return CModule_Icicle::Include();
+	}
+
+	// The loop of the device, every module gets its update and then the internet module serves whatever came in
+	static void
+	Loop(
+		uint32_t&	ioLastUS)
+	{
+		uint32_t	nowUS = micros();
+
+		((CModule*)Module())->Update(nowUS - ioLastUS);
+		ioLastUS = nowUS;
+	}
+
+	static void
+	ServePage(
+		char const*			inPath,
+		IOutputDirector*	inOutput)
+	{
+		for(SHostPage const& page : gHostPages)
+		{
+			if(page.path == inPath)
+			{
+				page.handler(inOutput, 0, NULL);
+			}
+		}
+	}
+
+	// Run settings_set with the space separated key=value pairs of inLine
+	static uint8_t
+	SettingsSet_Line(
+		std::string const&	inLine)
+	{
+		std::vector<std::string>	words;
+		std::vector<char const*>	argV = {"settings_set"};
+		CHostStdout					output;
+		size_t						start = 0;
+
+		while(start < inLine.size())
+		{
+			size_t	end = inLine.find_first_of(" \n", start);
+
+			end = end == std::string::npos ? inLine.size() : end;
+			if(end > start)
+			{
+				words.push_back(inLine.substr(start, end - start));
+			}
+			start = end + 1;
+		}
+
+		for(std::string const& word : words)
+		{
+			argV.push_back(word.c_str());
+		}
+
+		return Module()->SettingsSet(&output, int(argV.size()), argV.data());
+	}
+
+	// Let the settings go quiet and be written out, a slot is written a few bytes an update
+	static bool
+	SettingsStore_Settle(
+		uint32_t&	ioLastUS)
+	{
+		CModule_Icicle*	module = Module();
+
+		for(int i = 0; i < (eSettingsQuietUS + 1000000) / eUpdateTimeUS && (module->settingsDirty || module->settingsFlushing); ++i)
+		{
+			Loop(ioLastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		return module->settingsDirty == false && module->settingsFlushing == false;
+	}
+
+	// A burst of set commands is one write once they stop coming. When the power goes out part way through writing a slot
+	//	that slot fails its crc and the newest complete slot of the rest is loaded
+	static bool
+	SettingsStore(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		uint32_t		lastUS = micros();
+		uint32_t		flushCount = module->settingsFlushCount;
+
+		for(int i = 0; i < 20; ++i)
+		{
+			MTestCheck(SettingsSet_Line("streamtimeout=" + std::to_string(1000 + i)) == eCmd_Succeeded);
+			for(int j = 0; j < 100; ++j)
+			{
+				Loop(lastUS);
+				gHostClockOffsetUS += eUpdateTimeUS;
+			}
+		}
+
+		MTestCheck(module->settingsFlushCount == flushCount && module->settingsDirty);
+		MTestCheck(SettingsStore_Settle(lastUS));
+		MTestCheck(module->settingsFlushCount == flushCount + 1);
+
+		// Fill every slot and one more so the load has older good slots to pick from, before and after the newest
+		for(int i = 0; i <= eSettingsSlotCount; ++i)
+		{
+			MTestCheck(SettingsSet_Line("streamtimeout=" + std::to_string(0x1111 * (i + 1))) == eCmd_Succeeded);
+			MTestCheck(SettingsStore_Settle(lastUS));
+		}
+
+		uint8_t		goodSlot = module->settingsSlot;
+		uint32_t	goodSequence = module->settingsSequence;
+		uint16_t	goodTimeoutMS = module->settings.streamTimeoutMS;
+		uint32_t	writeCount = gSettingsStoreBackend.writeCount;
+
+		MTestCheck(goodSlot != 0 && goodSlot != eSettingsSlotCount - 1);
+
+		// The power goes out before the last byte of the next slot, the crc at the end of the header, so the slot has the
+		//	newest sequence but the crc of what was there before
+		MTestCheck(SettingsSet_Line("streamtimeout=500") == eCmd_Succeeded);
+		module->SettingsStore_StartFlush();
+
+		uint16_t	address = module->SettingsStore_SlotAddress(module->settingsFlushSlot);
+		uint32_t	changedBytes = 0;
+
+		for(size_t i = 0; i < sizeof(module->settingsFlushImage); ++i)
+		{
+			changedBytes += gSettingsStoreBackend.Read(uint16_t(address + i)) != module->settingsFlushImage[i] ? 1 : 0;
+		}
+
+		gSettingsStoreBackend.powerLossAfterWrites = writeCount + changedBytes - 1;
+		MTestCheck(SettingsStore_Settle(lastUS));
+		MTestCheck(gSettingsStoreBackend.writeCount == writeCount + changedBytes && module->settingsSlot != goodSlot);
+		MTestCheck(((SSettingsSlotHeader const*)(gSettingsStoreBackend.memory + address))->sequence == goodSequence + 1);
+
+		module->settings.streamTimeoutMS = 0;
+		module->SettingsStore_Load();
+
+		MTestCheck(module->settingsSlot == goodSlot && module->settingsSequence == goodSequence);
+		MTestCheck(module->settings.streamTimeoutMS == goodTimeoutMS && module->settingsDirty == false);
+
+		return true;
+	}
+
+	// Request the home and settings pages 10 times a second through a client that takes 20us a byte, a 1.6KB page holds
+	//	the loop up for more than a whole frame unless it is sliced. Returns the longest time between frame starts
+	static uint32_t
+	WebFlood_Run(
+		uint16_t	inSliceBytes,
+		uint16_t	inSliceUS)
+	{
+		CModule_Icicle*	module = Module();
+		CHostSlowClient	client(20);
+		uint32_t		lastUS = micros();
+		uint32_t		nextRequestUS = lastUS;
+		int				requests = 0;
+
+		module->settings.webSliceBytes = inSliceBytes;
+		module->settings.webSliceUS = inSliceUS;
+		module->FramePacing_ResetStats();
+
+		for(uint32_t startUS = lastUS; micros() - startUS < 3000000;)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+
+			if(int32_t(micros() - nextRequestUS) >= 0)
+			{
+				ServePage((requests++ & 1) ? "/settings" : "/", &client);
+				nextRequestUS += 100000;
+			}
+		}
+
+		printf("webslice %u bytes %u us: %d requests %u bytes, max frame interval %u us\n", inSliceBytes, inSliceUS, requests, client.totalBytes, module->frameIntervalMaxUS);
+
+		return module->frameIntervalMaxUS;
+	}
+
+	static bool
+	WebFlood(
+		void)
+	{
+		uint32_t	intervalUS = Module()->frameIntervalUS;
+
+		// A frame can start late by the tick it came due in, one slice and the frame before it
+		uint32_t	slackUS = eUpdateTimeUS * 3;
+
+		MTestCheck(WebFlood_Run(0, 0) > intervalUS + slackUS);
+		MTestCheck(WebFlood_Run(256, 0) > intervalUS + slackUS);
+		MTestCheck(WebFlood_Run(256, eUpdateTimeUS) <= intervalUS + slackUS);
+		MTestCheck(WebFlood_Run(64, 0) <= intervalUS + slackUS * 2);
+
+		return true;
+	}
+
+	// The render mode page only takes rendermode=<mode> and only saves the settings when the mode is one it knows
+	static bool
+	RenderModePage(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		CHostCapture	output;
+		char const*		allOn[] = {"rendermode", "allon"};
+		char const*		wrongName[] = {"gammar", "festive"};
+		char const*		badMode[] = {"rendermode", "sparkle"};
+		uint32_t		saveCount = module->settingsSaveCount;
+
+		module->CommandRenderModePageHandler(&output, 2, allOn);
+		MTestCheck(module->settings.renderMode == eRenderMode_AllOn && module->settingsSaveCount == saveCount + 1);
+
+		module->CommandRenderModePageHandler(&output, 2, wrongName);
+		module->CommandRenderModePageHandler(&output, 2, badMode);
+		module->CommandRenderModePageHandler(&output, 1, allOn);
+		MTestCheck(module->settings.renderMode == eRenderMode_AllOn && module->settingsSaveCount == saveCount + 1);
+
+		return true;
+	}
+
+	// One ArtDmx packet of a whole universe set to inValue
+	static void
+	Stream_Packet(
+		uint8_t		(&outPacket)[eStreamHeaderSize + eStreamLEDsPerUniverse * 3],
+		uint32_t	inUniverse,
+		uint8_t		inValue)
+	{
+		memset(outPacket, inValue, sizeof(outPacket));
+		memcpy(outPacket, "Art-Net", 8);
+		outPacket[8] = eStreamOpCode_Dmx & 0xFF;
+		outPacket[9] = eStreamOpCode_Dmx >> 8;
+		outPacket[10] = 0;
+		outPacket[11] = 14;
+		outPacket[12] = 0;
+		outPacket[13] = 0;
+		outPacket[14] = inUniverse & 0xFF;
+		outPacket[15] = inUniverse >> 8;
+		outPacket[16] = (eStreamLEDsPerUniverse * 3) >> 8;
+		outPacket[17] = (eStreamLEDsPerUniverse * 3) & 0xFF;
+	}
+
+	// A stream that stops before its first frame is complete must not leave its universes in the dynamic ice frame
+	static bool
+	StreamTimeout(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		uint32_t		lastUS = micros();
+		uint8_t			packet[eStreamHeaderSize + eStreamLEDsPerUniverse * 3];
+
+		module->settings.renderMode = eRenderMode_DynamicIce;
+
+		for(int i = 0; i < 200; ++i)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		// Only the icicles that change get drawn from here on
+		MTestCheck(module->frameInvalid == false);
+
+		Stream_Packet(packet, module->Stream_FirstUniverse(), 0xFF);
+		IcicleStream_Receive(packet, sizeof(packet));
+
+		gHostClockOffsetUS += uint32_t(module->settings.streamTimeoutMS) * 1000;
+
+		for(int i = 0; i < 50; ++i)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		MTestCheck(module->streamActive == false && module->streamTimeoutCount == 1);
+
+		// The frame has to match drawing the current model from scratch
+		static uint8_t	shownFrame[sizeof(gIcicleLEDFrame)];
+
+		memcpy(shownFrame, gIcicleLEDFrame, sizeof(gIcicleLEDFrame));
+		memset(gIcicleLEDFrame, 0, sizeof(gIcicleLEDFrame));
+		module->RenderDynamicIce();
+
+		MTestCheck(memcmp(shownFrame, gIcicleLEDFrame, sizeof(gIcicleLEDFrame)) == 0);
+
+		return true;
+	}
+
+	// Frames come in over UDP, receiving only decodes them and the next update shows them. A frame that arrives before
+	//	the last one was shown is dropped rather than torn
+	static bool
+	StreamUDP(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		int				receiveSocket = HostStreamUDP_Open(0);
+		int				sendSocket = socket(AF_INET, SOCK_DGRAM, 0);
+		uint8_t			packet[eStreamHeaderSize + eStreamLEDsPerUniverse * 3];
+		uint32_t		lastUS = micros();
+		sockaddr_in		addr;
+
+		MTestCheck(receiveSocket >= 0 && sendSocket >= 0);
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(HostStreamUDP_Port(receiveSocket));
+
+		for(int frame = 0; frame < 2; ++frame)
+		{
+			for(int i = 0; i < eStreamUniverseCount; ++i)
+			{
+				Stream_Packet(packet, module->Stream_FirstUniverse() + i, frame == 0 ? 0x40 : 0x80);
+				MTestCheck(sendto(sendSocket, packet, sizeof(packet), 0, (sockaddr*)&addr, sizeof(addr)) == sizeof(packet));
+			}
+		}
+
+		uint32_t	showCount = module->leds.showCount;
+
+		MTestCheck(HostStreamUDP_Poll(receiveSocket) == eStreamUniverseCount * 2);
+		MTestCheck(module->leds.showCount == showCount);
+		MTestCheck(module->streamFrameReady && module->streamOverrunCount == eStreamUniverseCount);
+		MTestCheck(gIcicleLEDFrame[0][0] == 0x40 && gIcicleLEDFrame[eStripCount - 1][eLEDsPerStrip * 3 - 1] == 0x40);
+
+		Loop(lastUS);
+
+		MTestCheck(module->leds.showCount == showCount + 1);
+		MTestCheck(module->renderedMode == eRenderMode_Stream && module->streamFrameCount == 1);
+
+		close(sendSocket);
+		close(receiveSocket);
+
+		return true;
+	}
+
+	// A recorded show opens from the index at its end without reading the records, one without an index is read a few
+	//	records per update and comes out the same
+	static bool
+	ShowIndex(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		CHostStdout		output;
+		char const*		argV[] = {"show_bench", "40", "8"};
+
+		MTestCheck(module->ShowBench(&output, 3, argV) == eCmd_Succeeded);
+
+		module->showChecked = false;
+		MTestCheck(module->ShowPlay_Open(1) && module->showFrameCount == 40 && module->showKeyframeCount == 5);
+
+		uint32_t	keyframeOffset[5];
+
+		memcpy(keyframeOffset, module->showKeyframeOffset, sizeof(keyframeOffset));
+
+		// Without its footer the index can't be found
+		--gShowStoreBackend.size;
+		module->showChecked = false;
+
+		int	updates = 1;
+
+		while(module->ShowPlay_Open(1) == false)
+		{
+			MTestCheck(module->showScanning && updates++ < 100);
+		}
+
+		MTestCheck(updates > 40 && module->showFrameCount == 40 && module->showKeyframeCount == 5);
+		MTestCheck(memcmp(keyframeOffset, module->showKeyframeOffset, sizeof(keyframeOffset)) == 0);
+
+		return true;
+	}
+
+	// Settings copied from node 1 of a roofline to node 0 of another one, as key=value pairs or as a blob, carry
+	//	everything but which node the controller is
+	static bool
+	SettingsCopy(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		CHostStdout		output;
+		CHostCapture	dump;
+		CHostCapture	blob;
+		char const*		fromNodeArgV[] = {"can_set", "1", "2"};
+		char const*		toNodeArgV[] = {"can_set", "0", "3"};
+		char const*		blobArgV[] = {"settings_get", "blob"};
+
+		MTestCheck(module->CANSet(&output, 3, fromNodeArgV) == eCmd_Succeeded);
+		MTestCheck(SettingsSet_Line("streamtimeout=1234") == eCmd_Succeeded);
+		module->SettingsGet(&dump, 1, blobArgV);
+		module->SettingsGet(&blob, 2, blobArgV);
+
+		MTestCheck(dump.text.find("cannode") == std::string::npos);
+
+		MTestCheck(module->CANSet(&output, 3, toNodeArgV) == eCmd_Succeeded);
+		MTestCheck(SettingsSet_Line("streamtimeout=500") == eCmd_Succeeded);
+		MTestCheck(SettingsSet_Line(dump.text) == eCmd_Succeeded);
+		MTestCheck(module->settings.streamTimeoutMS == 1234 && module->settings.canNodeIndex == 0 && module->settings.canNodeCount == 3);
+
+		MTestCheck(SettingsSet_Line("streamtimeout=500") == eCmd_Succeeded);
+		MTestCheck(SettingsSet_Line(blob.text) == eCmd_Succeeded);
+		MTestCheck(module->settings.streamTimeoutMS == 1234 && module->settings.canNodeIndex == 0 && module->settings.canNodeCount == 3);
+
+		// Setting the node by name still works
+		MTestCheck(SettingsSet_Line("cannode=2") == eCmd_Succeeded && module->settings.canNodeIndex == 2);
+
+		return true;
+	}
+
+	// Followers from a fixed seed all present ahead of their reads, within half a tick of node 0, and the settings make
+	//	it through the chunks of a broadcast
+	static bool
+	CANBench(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		CHostCapture	output;
+		char const*		argV[] = {"can_bench", "7", "2000", "12345"};
+
+		MTestCheck(module->CANBench(&output, 4, argV) == eCmd_Succeeded);
+		printf("%s", output.text.c_str());
+
+		size_t			jitter = output.text.find("present jitter us");
+		unsigned long	maxUS = 0;
+		unsigned long	lateCount = 1;
+
+		MTestCheck(jitter != std::string::npos);
+		MTestCheck(sscanf(output.text.c_str() + jitter, "present jitter us avg=%*f max=%lu late=%lu", &maxUS, &lateCount) == 2);
+		MTestCheck(lateCount == 0 && maxUS < eUpdateTimeUS / 2);
+		MTestCheck(output.text.find("settings broadcast=") != std::string::npos && output.text.find("us ok\n") != std::string::npos);
+
+		return true;
+	}
+
+	// The static modes draw and show their frame once and then skip every frame until a setting they read changes, the
+	//	tick us column of render_bench is the cost of the skipped frames
+	static bool
+	StaticSkip(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		uint32_t		lastUS = micros();
+		uint8_t const	modes[] = {eRenderMode_StaticIce, eRenderMode_AllOn, eRenderMode_AllOff, eRenderMode_Festive, eRenderMode_Strand};
+
+		for(uint8_t mode : modes)
+		{
+			module->settings.renderMode = mode;
+			for(int i = 0; i < 100; ++i)
+			{
+				Loop(lastUS);
+				gHostClockOffsetUS += eUpdateTimeUS;
+			}
+
+			uint32_t	showCount = module->leds.showCount;
+			uint32_t	skippedCount = module->skippedShowCount;
+
+			for(int i = 0; i < 300; ++i)
+			{
+				Loop(lastUS);
+				gHostClockOffsetUS += eUpdateTimeUS;
+			}
+
+			MTestCheck(module->leds.showCount == showCount && module->skippedShowCount >= skippedCount + 300 / (eFrameIntervalDefaultUS / eUpdateTimeUS));
+
+			MTestCheck(SettingsSet_Line(module->settings.gammaR > 2.0f ? "gammar=1.5" : "gammar=2.5") == eCmd_Succeeded);
+			for(int i = 0; i < 100; ++i)
+			{
+				Loop(lastUS);
+				gHostClockOffsetUS += eUpdateTimeUS;
+			}
+
+			// Gamma goes into the frame of every mode
+			MTestCheck(module->leds.showCount == showCount + 1);
+		}
+
+		return true;
+	}
+
+	// capacity_plan runs its shards on the icicles and frame of the module, it won't take them from dynamic ice and a mode
+	//	drawn from the settings comes back the same after it
+	static bool
+	CapacityPlan(
+		void)
+	{
+		CModule_Icicle*	module = Module();
+		CHostCapture	output;
+		uint32_t		lastUS = micros();
+		char const*		planArgV[] = {"capacity_plan", "2000", "5", "30", "4"};
+
+		module->settings.renderMode = eRenderMode_DynamicIce;
+		for(int i = 0; i < 100; ++i)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		static CModule_Icicle::SIcicleStates	icicles;
+
+		icicles = module->icicles;
+		MTestCheck(module->CapacityPlan(&output, 5, planArgV) == eCmd_Failed);
+		MTestCheck(memcmp(&icicles, &module->icicles, sizeof(icicles)) == 0);
+
+		module->settings.renderMode = eRenderMode_Festive;
+		for(int i = 0; i < 100; ++i)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		static uint8_t	shownDraw[sizeof(gIcicleLEDDrawMemory)];
+		uint32_t		showCount = module->leds.showCount;
+
+		memcpy(shownDraw, gIcicleLEDDrawMemory, sizeof(gIcicleLEDDrawMemory));
+		MTestCheck(module->CapacityPlan(&output, 5, planArgV) == eCmd_Succeeded);
+		MTestCheck(output.text.find("measured 3 shards") != std::string::npos);
+
+		for(int i = 0; i < 100; ++i)
+		{
+			Loop(lastUS);
+			gHostClockOffsetUS += eUpdateTimeUS;
+		}
+
+		MTestCheck(module->leds.showCount > showCount);
+		MTestCheck(memcmp(shownDraw, gIcicleLEDDrawMemory, sizeof(gIcicleLEDDrawMemory)) == 0);
+
+		return true;
+	}
+
+	// Print a hash of what every icicle is doing after each model tick, make test runs it on the packed model and on the
+	//	full width one and compares the two. The ticks vary and the run is long enough to wrap the 16 bit hold start, the
+	//	drip times are changed along the way so lazy apply takes drip starts back off the wheel
+	static bool
+	ModelTrace(
+		void)
+	{
+		CModule_Icicle*			module = Module();
+		CModule_Icicle::SIcicleStates const&	icicles = module->icicles;
+
+		MTestCheck(SettingsSet_Line("paramapply=lazy reseedperframe=16") == eCmd_Succeeded);
+		module->RandomSeed(1);
+		module->updateCumulatorUS = 0;
+		module->DynamicState_Reset();
+
+		for(int tick = 0; tick < 3000; ++tick)
+		{
+			if(tick % 500 == 250)
+			{
+				MTestCheck(SettingsSet_Line(tick % 1000 == 250 ? "driptimemean=2 driptimestd=1" : "driptimemean=12 driptimestd=4") == eCmd_Succeeded);
+			}
+
+			module->UpdateModel(eFrameIntervalDefaultUS * (1 + tick % 3) - tick % 7 * 1000);
+			module->ParamApply_Update();
+
+			uint32_t	hash = 2166136261UL;
+
+			for(int i = 0; i < eIcicleTotal; ++i)
+			{
+				bool		holding = icicles.IsHolding(i);
+				bool		dripping = icicles.IsDripping(i);
+				uint32_t	state[8] =
+				{
+					uint32_t(icicles.curDepth4dot12[i]),
+					uint32_t(icicles.growthRateLEDsPerSec4dot12[i]),
+					uint32_t(icicles.maxDepth4dot12[i]),
+					uint32_t(icicles.waterDripLoc4dot12[i]),
+					icicles.maxDepthLifeTime4dot12[i],
+					uint32_t(holding) | uint32_t(dripping) << 1,
+					holding ? icicles.GetHoldElapsed4dot12(i, icicles.modelTime4dot12) : 0,
+					dripping ? icicles.GetDripCountdown8dot8(i) : icicles.GetDripStartTime8dot8(i),
+				};
+
+				hash = module->SimHash(hash, state, 8);
+			}
+
+			printf("tick %d time 0x%08lx hash 0x%08lx\n", tick, (unsigned long)icicles.modelTime4dot12, (unsigned long)hash);
+		}
+
+		return true;
+	}
+};
+
+struct SHostTest
+{
+	char const*	name;
+	bool		(*run)(void);
+	bool		onlyNamed;	// Left out of the run with no arguments
+};
+
+static SHostTest const	gHostTests[] =
+{
+	{"settings_store", SIcicleHostTest::SettingsStore},
+	{"web_flood", SIcicleHostTest::WebFlood},
+	{"rendermode_page", SIcicleHostTest::RenderModePage},
+	{"stream_timeout", SIcicleHostTest::StreamTimeout},
+	{"stream_udp", SIcicleHostTest::StreamUDP},
+	{"show_index", SIcicleHostTest::ShowIndex},
+	{"settings_copy", SIcicleHostTest::SettingsCopy},
+	{"can_bench", SIcicleHostTest::CANBench},
+	{"static_skip", SIcicleHostTest::StaticSkip},
+	{"capacity_plan", SIcicleHostTest::CapacityPlan},
+	{"model_trace", SIcicleHostTest::ModelTrace, true},
+};
+
+int
+main(
+	int				inArgC,
+	char const**	inArgV)
+{
+	int	failed = 0;
+
+	for(SHostTest const& test : gHostTests)
+	{
+		bool	named = inArgC < 2 && test.onlyNamed == false;
+
+		for(int i = 1; i < inArgC; ++i)
+		{
+			named = named || strcmp(inArgV[i], test.name) == 0;
+		}
+
+		if(named == false)
+		{
+			continue;
+		}
+
+		fflush(stdout);
+
+		pid_t	child = fork();
+
+		if(child == 0)
+		{
+			CModule_Icicle*	module = CModule_Icicle::Include();
+
+			((CModule*)module)->Setup();
+			((IOutdoorLightingInterface*)module)->LEDStateChange(true);
+
+			bool	passed = test.run();
+
+			fflush(stdout);
+			_exit(passed ? 0 : 1);
+		}
+
+		int	status = 0;
+
+		waitpid(child, &status, 0);
+
+		bool	passed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+		printf("%s %s\n", test.name, passed ? "ok" : "FAILED");
+		failed += passed ? 0 : 1;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
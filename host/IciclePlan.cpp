@@ -0,0 +1,211 @@
+/*
+	Author: Brent Pease (embeddedlibraryfeedback@gmail.com)
+
+	The MIT License (MIT)
+
+	Copyright (c) 2015-FOREVER Brent Pease
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	ABOUT
+
+	Plans the controllers of a site too large to time on one controller, the capacity_plan command spread over every
+	core of the desktop.
+
+		icicle_plan [workers] [icicles] [LEDs per icicle] [fps] [frames]
+
+	The module and its frame buffers are globals so each worker is a process of its own with its own copy of them. The
+	workers take shards a few at a time from a counter they share, a worker that gets fast shards or a core of its own
+	just comes back for more, so the load evens out without splitting the site up front. The shards are the same ones
+	capacity_plan runs, a shard is a controller worth of icicles from a seed of its own, and the timings add up to the
+	same report. The workers default to the number of cores, the rest of the arguments default like capacity_plan's.
+	The shards are timed on the wall clock, with more workers than cores they time each other's time slices and both
+	the costs and how well the workers scaled come out high.
+
+		icicle_plan 0 500000 5 30
+*/
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../ModuleIcicleLights.cpp"
+
+enum
+{
+	ePlanWorkersMax = 256,
+
+	// Enough shards to a claim that the counter isn't contended, few enough that the last claims finish together
+	ePlanShardsPerClaim = 4,
+};
+
+// Lives in memory shared with the workers
+struct SPlanShared
+{
+	uint32_t		nextShard;
+	uint32_t		workerClaims[ePlanWorkersMax];
+	SCapacityTiming	workerTiming[ePlanWorkersMax];
+};
+
+struct SIcicleHostPlan
+{
+	static void
+	Worker_Run(
+		CModule_Icicle*	inModule,
+		SPlanShared*	inShared,
+		int				inWorker,
+		uint32_t		inShards,
+		uint32_t		inIntervalUS,
+		int				inFrames)
+	{
+		SCapacityTiming	timing = {};
+		uint32_t		seed = inModule->randomSeed;
+
+		for(;;)
+		{
+			uint32_t	first = __atomic_fetch_add(&inShared->nextShard, ePlanShardsPerClaim, __ATOMIC_RELAXED);
+
+			if(first >= inShards)
+			{
+				break;
+			}
+
+			uint32_t	count = inShards - first < ePlanShardsPerClaim ? inShards - first : ePlanShardsPerClaim;
+
+			inModule->CapacityPlan_RunShards(seed, first, count, inIntervalUS, inFrames, timing);
+			++inShared->workerClaims[inWorker];
+		}
+
+		inShared->workerTiming[inWorker] = timing;
+	}
+
+	static bool
+	Run(
+		CModule_Icicle*	inModule,
+		int				inWorkers,
+		uint32_t		inSiteIcicles,
+		uint32_t		inLEDsPerIcicle,
+		uint32_t		inFPS,
+		int				inFrames)
+	{
+		CHostStdout	output;
+
+		if(CModule_Icicle::CapacityPlan_Valid(inSiteIcicles, inLEDsPerIcicle, inFPS, inFrames) == false)
+		{
+			fprintf(stderr, "can't plan that site\n");
+			return false;
+		}
+
+		SPlanShared*	shared = (SPlanShared*)mmap(NULL, sizeof(SPlanShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+		if(shared == MAP_FAILED)
+		{
+			fprintf(stderr, "can't share memory with the workers\n");
+			return false;
+		}
+
+		memset(shared, 0, sizeof(SPlanShared));
+
+		uint32_t	shards = (inSiteIcicles + eIcicleTotal - 1) / eIcicleTotal;
+		uint32_t	startUS = micros();
+		pid_t		workers[ePlanWorkersMax];
+
+		// The module is set up before the fork so every worker starts from the same settings and seed
+		for(int i = 0; i < inWorkers; ++i)
+		{
+			fflush(stdout);
+			workers[i] = fork();
+			if(workers[i] == 0)
+			{
+				Worker_Run(inModule, shared, i, shards, 1000000 / inFPS, inFrames);
+				_exit(0);
+			}
+		}
+
+		bool	failed = false;
+
+		for(int i = 0; i < inWorkers; ++i)
+		{
+			int	status = 0;
+
+			waitpid(workers[i], &status, 0);
+			failed = failed || workers[i] < 0 || WIFEXITED(status) == false || WEXITSTATUS(status) != 0;
+		}
+
+		uint32_t		wallUS = micros() - startUS;
+		SCapacityTiming	timing = {};
+		uint32_t		claimsMin = 0xFFFFFFFF;
+		uint32_t		claimsMax = 0;
+
+		for(int i = 0; i < inWorkers; ++i)
+		{
+			SCapacityTiming const&	workerTiming = shared->workerTiming[i];
+
+			timing.shards += workerTiming.shards;
+			timing.updateUS += workerTiming.updateUS;
+			timing.renderUS += workerTiming.renderUS;
+			timing.transposeUS += workerTiming.transposeUS;
+			timing.shardMaxUS = workerTiming.shardMaxUS > timing.shardMaxUS ? workerTiming.shardMaxUS : timing.shardMaxUS;
+			claimsMin = shared->workerClaims[i] < claimsMin ? shared->workerClaims[i] : claimsMin;
+			claimsMax = shared->workerClaims[i] > claimsMax ? shared->workerClaims[i] : claimsMax;
+		}
+
+		munmap(shared, sizeof(SPlanShared));
+
+		if(failed || timing.shards != shards)
+		{
+			fprintf(stderr, "a worker failed, %u of %u shards ran\n", timing.shards, shards);
+			return false;
+		}
+
+		// The wall time against the time the shards took on their own is how well the workers scaled
+		float	shardsUS = float(timing.updateUS + timing.renderUS + timing.transposeUS) * float(inFrames) / float(inFrames - 1);
+
+		printf("%d workers ran %u shards in %1.2f s, %1.0f shards/s, %1.1fx one worker, %u-%u claims of %d shards a worker\n", inWorkers, shards, float(wallUS) / 1000000.0f, float(shards) * 1000000.0f / float(wallUS), shardsUS / float(wallUS), claimsMin, claimsMax, ePlanShardsPerClaim);
+		inModule->CapacityPlan_Report(&output, inSiteIcicles, inLEDsPerIcicle, inFPS, inFrames, timing);
+
+		return true;
+	}
+};
+
+int
+main(
+	int				inArgC,
+	char const**	inArgV)
+{
+	CModule_Icicle*	module = CModule_Icicle::Include();
+
+	((CModule*)module)->Setup();
+
+	int			workers = inArgC >= 2 ? atoi(inArgV[1]) : 0;
+	uint32_t	siteIcicles = inArgC >= 3 ? (uint32_t)strtoul(inArgV[2], NULL, 0) : eIcicleTotal * eCANNodeMax;
+	uint32_t	ledsPerIcicle = inArgC >= 4 ? (uint32_t)strtoul(inArgV[3], NULL, 0) : eLEDsPerIcicle;
+	uint32_t	fps = inArgC >= 5 ? (uint32_t)strtoul(inArgV[4], NULL, 0) : 1000000 / eFrameIntervalDefaultUS;
+	int			frames = inArgC >= 6 ? atoi(inArgV[5]) : 30;
+
+	if(workers <= 0)
+	{
+		workers = int(sysconf(_SC_NPROCESSORS_ONLN));
+	}
+	workers = workers < 1 ? 1 : workers > ePlanWorkersMax ? ePlanWorkersMax : workers;
+
+	return SIcicleHostPlan::Run(module, workers, siteIcicles, ledsPerIcicle, fps, frames) ? 0 : 1;
+}
@@ -0,0 +1,2 @@
+// Host stand-in, everything the module uses from the Embedded Library is in HostEL.h
+#include "HostEL.h"
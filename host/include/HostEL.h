@@ -0,0 +1,440 @@
+/*
+	Author: Brent Pease (embeddedlibraryfeedback@gmail.com)
+
+	The MIT License (MIT)
+
+	Copyright (c) 2015-FOREVER Brent Pease
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	ABOUT
+
+	Just enough of the Embedded Library, OctoWS2811 and the Teensy core for ModuleIcicleLights.cpp to build with
+	WIN32 defined on a desktop compiler. Commands and pages register into tables the host programs look them up in,
+	micros() is the host clock plus however far the host programs have stepped it, and OctoWS2811 keeps its buffers
+	so getPixel() and the display memory behave like the device.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <math.h>
+#include <time.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Teensy core
+
+#define DMAMEM
+
+inline uint32_t	gHostClockOffsetUS = 0;
+
+inline uint32_t
+micros(
+	void)
+{
+	timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return uint32_t(uint64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000) + gHostClockOffsetUS;
+}
+
+inline uint32_t
+millis(
+	void)
+{
+	return micros() / 1000;
+}
+
+inline int	Serial1;
+
+// ELAssert
+
+#define MAssert(inCondition) do { if(!(inCondition)) { fprintf(stderr, "assert %s:%d %s\n", __FILE__, __LINE__, #inCondition); abort(); } } while(0)
+#define MReturnOnError(inCondition, inResult) do { if(inCondition) { return inResult; } } while(0)
+
+// ELOutput
+
+class IOutputDirector
+{
+public:
+
+	virtual void
+	write(
+		char const*	inMsg,
+		size_t		inBytes) = 0;
+
+	void
+	printf(
+		char const*	inMsg,
+		...)
+	{
+		char	buffer[1024];
+		va_list	varArgs;
+
+		va_start(varArgs, inMsg);
+		int	length = vsnprintf(buffer, sizeof(buffer), inMsg, varArgs);
+		va_end(varArgs);
+
+		write(buffer, length < int(sizeof(buffer)) ? size_t(length) : sizeof(buffer) - 1);
+	}
+};
+
+class CHostStdout : public IOutputDirector
+{
+public:
+
+	virtual void
+	write(
+		char const*	inMsg,
+		size_t		inBytes)
+	{
+		fwrite(inMsg, 1, inBytes, stdout);
+	}
+};
+
+// ELCommand
+
+enum
+{
+	eCmd_Succeeded = 0,
+	eCmd_Failed = 1,
+};
+
+class ICmdHandler
+{
+};
+
+struct SHostCommand
+{
+	std::string	name;
+	std::function<uint8_t(IOutputDirector*, int, char const**)>	handler;
+};
+
+inline std::vector<SHostCommand>	gHostCommands;
+
+template<typename tObject>
+void
+HostCommand_Register(
+	char const*	inName,
+	tObject*	inObject,
+	uint8_t		(tObject::*inMethod)(IOutputDirector*, int, char const**))
+{
+	gHostCommands.push_back({inName, [inObject, inMethod](IOutputDirector* inOutput, int inArgC, char const** inArgV) {return (inObject->*inMethod)(inOutput, inArgC, inArgV);}});
+}
+
+#define MCommandRegister(inName, inMethod, inHelp) HostCommand_Register(inName, this, &inMethod)
+
+// ELInternet
+
+class IInternetHandler
+{
+};
+
+struct SHostPage
+{
+	std::string	path;
+	std::function<void(IOutputDirector*, int, char const**)>	handler;
+};
+
+inline std::vector<SHostPage>	gHostPages;
+
+template<typename tObject>
+void
+HostPage_Register(
+	char const*	inPath,
+	tObject*	inObject,
+	void		(tObject::*inMethod)(IOutputDirector*, int, char const**))
+{
+	gHostPages.push_back({inPath, [inObject, inMethod](IOutputDirector* inOutput, int inArgC, char const** inArgV) {(inObject->*inMethod)(inOutput, inArgC, inArgV);}});
+}
+
+#define MInternetRegisterPage(inPath, inMethod) HostPage_Register(inPath, this, &inMethod)
+
+struct IInternetDevice
+{
+};
+
+struct CModule_ESP8266
+{
+	static IInternetDevice*
+	Include(
+		int,
+		void*,
+		int)
+	{
+		return NULL;
+	}
+};
+
+struct CModule_Internet
+{
+	static void
+	Include(
+		void)
+	{
+	}
+
+	void
+	Configure(
+		IInternetDevice*)
+	{
+	}
+
+	void
+	WebServer_Start(
+		int)
+	{
+	}
+};
+
+inline CModule_Internet		gHostInternetModule;
+inline CModule_Internet*	gInternetModule = &gHostInternetModule;
+
+// ELModule
+
+class CModule
+{
+public:
+
+	CModule(
+		int,
+		int,
+		void*,
+		uint32_t)
+	{
+	}
+
+	virtual
+	~CModule(
+		)
+	{
+	}
+
+	virtual void
+	Setup(
+		void)
+	{
+	}
+
+	virtual void
+	Update(
+		uint32_t)
+	{
+	}
+
+	virtual void
+	EEPROMInitialize(
+		void)
+	{
+	}
+
+	void
+	AddSysMsgHandler(
+		void*)
+	{
+	}
+};
+
+#define MModule_Declaration(inClass) static inClass* Include(void) { static inClass* module = new inClass(); return module; }
+#define MModuleImplementation_Start(inClass)
+#define MModuleImplementation_Finish(inClass)
+
+struct CModule_Command
+{
+	static void
+	Include(
+		void)
+	{
+	}
+};
+
+struct CModule_Loggly
+{
+	static CModule_Loggly*
+	Include(
+		char const*,
+		char const*,
+		char const*)
+	{
+		return NULL;
+	}
+};
+
+// ELRealTime
+
+struct IRealTimeDataProvider
+{
+};
+
+inline IRealTimeDataProvider*
+CreateDS3234Provider(
+	int)
+{
+	return NULL;
+}
+
+struct CModule_RealTime
+{
+	static void
+	Include(
+		void)
+	{
+	}
+
+	void
+	Configure(
+		IRealTimeDataProvider*,
+		uint32_t)
+	{
+	}
+};
+
+inline CModule_RealTime		gHostRealTime;
+inline CModule_RealTime*	gRealTime = &gHostRealTime;
+
+// ELOutdoorLightingControl
+
+class IOutdoorLightingInterface
+{
+public:
+
+	virtual void
+	LEDStateChange(
+		bool	inLEDsOn) = 0;
+
+	virtual void
+	MotionSensorStateChange(
+		bool	inMotionSensorTrigger) = 0;
+
+	virtual void
+	PushButtonStateChange(
+		int	inToggleCount) = 0;
+
+	virtual void
+	TimeOfDayChange(
+		int	inTimeOfDay) = 0;
+};
+
+struct CModule_OutdoorLightingControl
+{
+	static void
+	Include(
+		IOutdoorLightingInterface*,
+		int,
+		int,
+		int,
+		void*)
+	{
+	}
+};
+
+// OctoWS2811, show() doesn't wait on anything so busy() is never true
+
+#define WS2811_RGB 0
+
+class OctoWS2811
+{
+public:
+
+	OctoWS2811(
+		uint32_t	inLEDsPerStrip,
+		void*		inFrameBuffer,
+		void*		inDrawBuffer,
+		uint8_t		inConfig)
+	:
+		ledsPerStrip(inLEDsPerStrip),
+		frameBuffer((uint8_t*)inFrameBuffer),
+		drawBuffer(inDrawBuffer != NULL ? (uint8_t*)inDrawBuffer : (uint8_t*)inFrameBuffer)
+	{
+	}
+
+	void
+	begin(
+		void)
+	{
+	}
+
+	void
+	show(
+		void)
+	{
+		// Without a draw buffer the frame is drawn straight into the frame buffer
+		if(drawBuffer != frameBuffer)
+		{
+			memcpy(frameBuffer, drawBuffer, ledsPerStrip * 24);
+		}
+		++showCount;
+	}
+
+	bool
+	busy(
+		void)
+	{
+		return false;
+	}
+
+	void
+	setPixel(
+		uint32_t	inLED,
+		int			inR,
+		int			inG,
+		int			inB)
+	{
+		uint32_t	strip = inLED / ledsPerStrip;
+		uint8_t*	bits = drawBuffer + (inLED % ledsPerStrip) * 24;
+		uint32_t	color = (uint32_t(inR) << 16) | (uint32_t(inG) << 8) | uint32_t(inB);
+
+		for(int i = 0; i < 24; ++i)
+		{
+			bits[i] = (color & (0x800000 >> i)) ? bits[i] | (1 << strip) : bits[i] & ~(1 << strip);
+		}
+	}
+
+	int
+	getPixel(
+		uint32_t	inLED)
+	{
+		uint32_t	strip = inLED / ledsPerStrip;
+		uint8_t*	bits = drawBuffer + (inLED % ledsPerStrip) * 24;
+		int			color = 0;
+
+		for(int i = 0; i < 24; ++i)
+		{
+			color = (color << 1) | ((bits[i] >> strip) & 1);
+		}
+
+		return color;
+	}
+
+	uint32_t	ledsPerStrip;
+	uint8_t*	frameBuffer;
+	uint8_t*	drawBuffer;
+	uint32_t	showCount = 0;
+};